@@ -9,10 +9,13 @@
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <valarray>
 #include <vector>
 #include <gfx/timsort.hpp>
 #include "benchmarker.hpp"
+#include "counting.hpp"
+#include "distributions.hpp"
 
 namespace
 {
@@ -123,8 +126,56 @@ private:
     }
 };
 
+// Counts the comparisons, moves and copies performed when merging the two sorted
+// halves of each distribution instead of timing them
+template <typename value_t>
+void count(int size) {
+    bench::print_counts_header(std::cerr);
+    for (auto dist : bench::all_distributions) {
+        auto source = bench::make_counted(bench::generate<value_t>(dist, size));
+        const auto middle = source.size() / 2;
+        std::sort(source.begin(), source.begin() + middle);
+        std::sort(source.begin() + middle, source.end());
+        const auto run = [&](std::string_view name, auto merge) {
+            auto b = source;
+            const auto res = bench::count_operations([&] {
+                merge(b.begin(), b.begin() + middle, b.end(), bench::counting_less{});
+            });
+            bench::print_counts(std::cerr, bench::name(dist), name, res, b.size());
+        };
+
+        run("std::inplace_merge", [](auto first, auto mid, auto last, auto comp) {
+            std::inplace_merge(first, mid, last, comp);
+        });
+        run("timmerge", [](auto first, auto mid, auto last, auto comp) {
+            gfx::timmerge(first, mid, last, comp);
+        });
+        bench::print_lower_bound(std::cerr, bench::name(dist), "log2(C(n, n/2))",
+                                 bench::merge_lower_bound(middle, source.size() - middle),
+                                 source.size());
+    }
+}
+
 int main(int argc, const char *argv[]) {
-    const int size = argc > 1 ? std::stoi(argv[1]) : 100 * 1000;
+    int size = 100 * 1000;
+    bool counting = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--count") {
+            counting = true;
+        } else {
+            size = std::stoi(argv[i]);
+        }
+    }
+
+    if (counting) {
+        std::cerr << "size\t" << size << std::endl;
+        std::cerr << "[int]" << std::endl;
+        count<int>(size);
+        std::cerr << "[std::string]" << std::endl;
+        count<std::string>(size);
+        return 0;
+    }
+
     Benchmarker<Bench> benchmarker(size);
     benchmarker.run();
 }
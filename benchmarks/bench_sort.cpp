@@ -8,9 +8,13 @@
 #include <ctime>
 #include <algorithm>
 #include <iostream>
+#include <string>
+#include <string_view>
 #include <vector>
 #include <gfx/timsort.hpp>
 #include "benchmarker.hpp"
+#include "counting.hpp"
+#include "distributions.hpp"
 
 template <typename value_t>
 struct Bench {
@@ -56,8 +60,49 @@ struct Bench {
     }
 };
 
+// Counts the comparisons, moves and copies performed by each algorithm
+// instead of timing them
+template <typename value_t>
+void count(int size) {
+    bench::print_counts_header(std::cerr);
+    for (auto dist : bench::all_distributions) {
+        const auto source = bench::make_counted(bench::generate<value_t>(dist, size));
+        const auto run = [&](std::string_view name, auto sort) {
+            auto b = source;
+            const auto res = bench::count_operations([&] { sort(b, bench::counting_less{}); });
+            bench::print_counts(std::cerr, bench::name(dist), name, res, b.size());
+        };
+
+        run("std::sort", [](auto& b, auto comp) { std::sort(b.begin(), b.end(), comp); });
+        run("std::stable_sort", [](auto& b, auto comp) {
+            std::stable_sort(b.begin(), b.end(), comp);
+        });
+        run("timsort", [](auto& b, auto comp) { gfx::timsort(b, comp); });
+        bench::print_lower_bound(std::cerr, bench::name(dist), "log2(n!)",
+                                 bench::sort_lower_bound(source.size()), source.size());
+    }
+}
+
 int main(int argc, const char *argv[]) {
-    const int size = argc > 1 ? std::atoi(argv[1]) : 100 * 1000;
+    int size = 100 * 1000;
+    bool counting = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--count") {
+            counting = true;
+        } else {
+            size = std::atoi(argv[i]);
+        }
+    }
+
+    if (counting) {
+        std::cerr << "size\t" << size << std::endl;
+        std::cerr << "[int]" << std::endl;
+        count<int>(size);
+        std::cerr << "[std::string]" << std::endl;
+        count<std::string>(size);
+        return 0;
+    }
+
     Benchmarker<Bench> benchmarker(size);
     benchmarker.run();
 }
@@ -0,0 +1,402 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <gfx/timsort.hpp>
+#include "distributions.hpp"
+#include "measure.hpp"
+
+namespace
+{
+    struct options {
+        std::vector<std::size_t> sizes = { 16, 256, 4096, 65536, 1000000 };
+        std::vector<bench::distribution> distributions = {
+            std::begin(bench::all_distributions), std::end(bench::all_distributions)
+        };
+        std::vector<std::string> types = { "int", "double", "string", "pair", "blob64", "blob256" };
+        std::vector<std::string> algorithms = {
+            "timsort", "std::stable_sort", "std::sort", "pointer_sort", "timsort_indices"
+        };
+        std::size_t warmups = 1;
+        std::size_t repetitions = 5;
+        std::size_t max_bytes = std::size_t(1) << 30;
+        std::string format = "text";
+        std::string output;
+        bool counters = false;
+    };
+
+    struct result {
+        std::string algorithm;
+        std::string type;
+        std::string_view distribution;
+        std::size_t size;
+        bench::timing timing;
+    };
+
+    [[noreturn]] void usage(int exit_code) {
+        std::cerr <<
+            "usage: bench_suite [options]\n"
+            "  --sizes=N,...          sizes to benchmark, scientific notation is accepted (1e8)\n"
+            "  --distributions=D,...  sorted, reversed, shuffled, sawtooth, organ_pipe,\n"
+            "                         few_unique, k_swaps, random_runs, random_tail,\n"
+            "                         ascending_noise, zipf\n"
+            "  --types=T,...          int, double, string, pair, blob64, blob128, blob256,\n"
+            "                         blob512, move64, move256, boxed64, or objects for\n"
+            "                         all the element size and move cost types\n"
+            "  --algorithms=A,...     timsort, std::stable_sort, std::sort, pointer_sort,\n"
+            "                         timsort_indices\n"
+            "  --warmups=N            untimed runs before each measurement (default 1)\n"
+            "  --repetitions=N        timed runs per measurement (default 5)\n"
+            "  --max-bytes=N          skip inputs larger than N bytes (default 1073741824)\n"
+            "  --format=F             text, csv or json (default text)\n"
+            "  --output=FILE          write the results to FILE instead of stdout\n"
+            "  --counters             read hardware counters around each sort (Linux only)\n";
+        std::exit(exit_code);
+    }
+
+    std::vector<std::string> split(std::string_view str) {
+        std::vector<std::string> res;
+        while (!str.empty()) {
+            auto comma = str.find(',');
+            res.emplace_back(str.substr(0, comma));
+            str.remove_prefix(comma == std::string_view::npos ? str.size() : comma + 1);
+        }
+        return res;
+    }
+
+    std::size_t parse_size(std::string const& str) {
+        try {
+            return static_cast<std::size_t>(std::stod(str));
+        } catch (std::exception const&) {
+            std::cerr << "invalid number: " << str << '\n';
+            usage(EXIT_FAILURE);
+        }
+    }
+
+    options parse_options(int argc, const char *argv[]) {
+        options opts;
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            auto eq = arg.find('=');
+            auto key = arg.substr(0, eq);
+            auto value = std::string(eq == std::string_view::npos ? "" : arg.substr(eq + 1));
+
+            if (key == "--help") {
+                usage(EXIT_SUCCESS);
+            } else if (key == "--sizes") {
+                opts.sizes.clear();
+                for (auto const& size : split(value)) {
+                    opts.sizes.push_back(parse_size(size));
+                }
+            } else if (key == "--distributions") {
+                opts.distributions.clear();
+                for (auto const& name : split(value)) {
+                    auto dist = bench::parse_distribution(name);
+                    if (!dist) {
+                        std::cerr << "unknown distribution: " << name << '\n';
+                        usage(EXIT_FAILURE);
+                    }
+                    opts.distributions.push_back(*dist);
+                }
+            } else if (key == "--types") {
+                opts.types.clear();
+                for (auto const& type : split(value)) {
+                    if (type == "objects") {
+                        opts.types.insert(opts.types.end(), {
+                            "string", "blob64", "blob128", "blob256", "blob512",
+                            "move64", "move256", "boxed64"
+                        });
+                    } else {
+                        opts.types.push_back(type);
+                    }
+                }
+            } else if (key == "--algorithms") {
+                opts.algorithms = split(value);
+            } else if (key == "--warmups") {
+                opts.warmups = parse_size(value);
+            } else if (key == "--repetitions") {
+                opts.repetitions = (std::max)(parse_size(value), std::size_t(1));
+            } else if (key == "--max-bytes") {
+                opts.max_bytes = parse_size(value);
+            } else if (key == "--format"
+                       && (value == "text" || value == "csv" || value == "json")) {
+                opts.format = value;
+            } else if (key == "--output") {
+                opts.output = value;
+            } else if (key == "--counters") {
+                opts.counters = true;
+            } else {
+                std::cerr << "unknown option: " << arg << '\n';
+                usage(EXIT_FAILURE);
+            }
+        }
+        return opts;
+    }
+
+    std::string json_string(std::string_view str) {
+        std::string res = "\"";
+        for (char c : str) {
+            if (c == '"' || c == '\\') {
+                res += '\\';
+            }
+            res += c;
+        }
+        return res + '"';
+    }
+
+    // Text results are streamed as they come, CSV and JSON ones are written at the end;
+    // the counters are shown per element in text and per run otherwise
+    class reporter {
+    public:
+        reporter(std::ostream& out, std::string format, bool counters) :
+            out_(out), format_(std::move(format)), counters_(counters) {
+            out_ << std::fixed << std::setprecision(3);
+            if (format_ == "text") {
+                out_ << std::left << std::setw(18) << "algorithm" << std::setw(10) << "type"
+                     << std::setw(17) << "distribution" << std::right << std::setw(11) << "size"
+                     << std::setw(16) << "median (us)" << std::setw(16) << "min (us)"
+                     << std::setw(12) << "ns/elem";
+                if (counters_) {
+                    for (auto name : bench::counter_names) {
+                        out_ << ' ' << std::setw(18) << (std::string(name) + "/elem");
+                    }
+                }
+                out_ << '\n';
+            }
+        }
+
+        void add(result res) {
+            if (format_ == "text") {
+                out_ << std::left << std::setw(18) << res.algorithm << std::setw(10) << res.type
+                     << std::setw(17) << res.distribution << std::right << std::setw(11) << res.size
+                     << std::setw(16) << res.timing.median_ns / 1e3
+                     << std::setw(16) << res.timing.min_ns / 1e3
+                     << std::setw(12) << per_element(res);
+                if (counters_) {
+                    for (auto const& value : res.timing.counters) {
+                        out_ << ' ' << std::setw(18);
+                        if (value && res.size) {
+                            out_ << *value / static_cast<double>(res.size);
+                        } else {
+                            out_ << '-';
+                        }
+                    }
+                }
+                out_ << std::endl;
+            } else {
+                results_.push_back(std::move(res));
+            }
+        }
+
+        void finish() {
+            if (format_ == "csv") {
+                out_ << "algorithm,type,distribution,size,repetitions,"
+                        "min_ns,median_ns,mean_ns,ns_per_element";
+                if (counters_) {
+                    for (auto name : bench::counter_names) {
+                        out_ << ',' << name;
+                    }
+                }
+                out_ << '\n';
+                for (auto const& res : results_) {
+                    out_ << res.algorithm << ',' << res.type << ',' << res.distribution << ','
+                         << res.size << ',' << res.timing.repetitions << ','
+                         << res.timing.min_ns << ',' << res.timing.median_ns << ','
+                         << res.timing.mean_ns << ',' << per_element(res);
+                    if (counters_) {
+                        for (auto const& value : res.timing.counters) {
+                            out_ << ',';
+                            if (value) {
+                                out_ << *value;
+                            }
+                        }
+                    }
+                    out_ << '\n';
+                }
+            } else if (format_ == "json") {
+                out_ << "{\n  \"results\": [";
+                for (std::size_t i = 0; i < results_.size(); ++i) {
+                    auto const& res = results_[i];
+                    out_ << (i ? ",\n" : "\n") << "    {"
+                         << "\"algorithm\": " << json_string(res.algorithm)
+                         << ", \"type\": " << json_string(res.type)
+                         << ", \"distribution\": " << json_string(res.distribution)
+                         << ", \"size\": " << res.size
+                         << ", \"repetitions\": " << res.timing.repetitions
+                         << ", \"min_ns\": " << res.timing.min_ns
+                         << ", \"median_ns\": " << res.timing.median_ns
+                         << ", \"mean_ns\": " << res.timing.mean_ns
+                         << ", \"ns_per_element\": " << per_element(res);
+                    if (counters_) {
+                        out_ << ", \"counters\": {";
+                        for (std::size_t j = 0; j < bench::counter_count; ++j) {
+                            out_ << (j ? ", " : "") << json_string(bench::counter_names[j]) << ": ";
+                            if (auto const& value = res.timing.counters[j]) {
+                                out_ << *value;
+                            } else {
+                                out_ << "null";
+                            }
+                        }
+                        out_ << '}';
+                    }
+                    out_ << '}';
+                }
+                out_ << "\n  ]\n}\n";
+            }
+            out_.flush();
+        }
+
+    private:
+        static double per_element(result const& res) {
+            return res.size ? res.timing.median_ns / static_cast<double>(res.size) : 0.0;
+        }
+
+        std::ostream& out_;
+        std::string format_;
+        bool counters_;
+        std::vector<result> results_;
+    };
+
+    // Memory used by an element, including what it owns on the heap
+    template <typename T>
+    constexpr std::size_t element_bytes = sizeof(T);
+
+    template <typename T>
+    constexpr std::size_t element_bytes<bench::boxed<T>> = sizeof(bench::boxed<T>) + sizeof(T);
+
+    // Indirect baseline: sorts pointers to the elements, then moves the elements
+    // to their final place through a second buffer
+    template <typename T>
+    void pointer_sort(std::vector<T>& vec) {
+        std::vector<T*> pointers;
+        pointers.reserve(vec.size());
+        for (auto& elem : vec) {
+            pointers.push_back(&elem);
+        }
+        std::stable_sort(pointers.begin(), pointers.end(), [](T* lhs, T* rhs) {
+            return *lhs < *rhs;
+        });
+        std::vector<T> sorted;
+        sorted.reserve(vec.size());
+        for (T* ptr : pointers) {
+            sorted.push_back(std::move(*ptr));
+        }
+        vec.swap(sorted);
+    }
+
+    template <typename T>
+    void run_type(options const& opts, std::string const& type_name, reporter& report,
+                  bench::perf_counters* counters) {
+        using sorter = std::function<void(std::vector<T>&)>;
+        const std::pair<std::string_view, sorter> sorters[] = {
+            { "timsort", [](std::vector<T>& vec) { gfx::timsort(vec); } },
+            { "std::stable_sort", [](std::vector<T>& vec) { std::ranges::stable_sort(vec); } },
+            { "std::sort", [](std::vector<T>& vec) { std::ranges::sort(vec); } },
+            { "pointer_sort", [](std::vector<T>& vec) { pointer_sort(vec); } },
+            { "timsort_indices", [](std::vector<T>& vec) {
+                gfx::apply_permutation(vec, gfx::timsort_indices(vec));
+            } },
+        };
+
+        for (std::size_t size : opts.sizes) {
+            if (size > opts.max_bytes / element_bytes<T>) {
+                std::cerr << "skipping " << type_name << " x " << size
+                          << ": exceeds --max-bytes" << std::endl;
+                continue;
+            }
+            for (auto dist : opts.distributions) {
+                const auto source = bench::generate<T>(dist, size);
+                std::vector<T> work;
+                for (auto const& [algo_name, sort] : sorters) {
+                    if (std::find(opts.algorithms.begin(), opts.algorithms.end(),
+                                  algo_name) == opts.algorithms.end()) {
+                        continue;
+                    }
+                    auto timing = bench::measure(
+                        opts.warmups, opts.repetitions,
+                        [&] { work = source; },
+                        [&] { sort(work); },
+                        [&] {
+                            // Checking the result also keeps the compiler from dropping the sort
+                            if (!std::is_sorted(work.begin(), work.end())) {
+                                std::cerr << algo_name << " did not sort the input\n";
+                                std::abort();
+                            }
+                        },
+                        counters
+                    );
+                    report.add({ std::string(algo_name), type_name, bench::name(dist),
+                                 size, timing });
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    const options opts = parse_options(argc, argv);
+
+    std::ofstream file;
+    if (!opts.output.empty()) {
+        file.open(opts.output);
+        if (!file) {
+            std::cerr << "could not open " << opts.output << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::optional<bench::perf_counters> perf;
+    if (opts.counters) {
+        perf.emplace();
+        if (!perf->available()) {
+            std::cerr << "hardware counters are not available, check perf_event_paranoid\n";
+        }
+    }
+    bench::perf_counters* counters = perf ? &*perf : nullptr;
+    reporter report(opts.output.empty() ? std::cout : file, opts.format, opts.counters);
+
+    for (auto const& type : opts.types) {
+        if (type == "int") {
+            run_type<int>(opts, type, report, counters);
+        } else if (type == "double") {
+            run_type<double>(opts, type, report, counters);
+        } else if (type == "string") {
+            run_type<std::string>(opts, type, report, counters);
+        } else if (type == "pair") {
+            run_type<std::pair<int, int>>(opts, type, report, counters);
+        } else if (type == "blob64") {
+            run_type<bench::blob<64>>(opts, type, report, counters);
+        } else if (type == "blob128") {
+            run_type<bench::blob<128>>(opts, type, report, counters);
+        } else if (type == "blob256") {
+            run_type<bench::blob<256>>(opts, type, report, counters);
+        } else if (type == "blob512") {
+            run_type<bench::blob<512>>(opts, type, report, counters);
+        } else if (type == "move64") {
+            run_type<bench::heavy_move<64>>(opts, type, report, counters);
+        } else if (type == "move256") {
+            run_type<bench::heavy_move<256>>(opts, type, report, counters);
+        } else if (type == "boxed64") {
+            run_type<bench::boxed<bench::blob<64>>>(opts, type, report, counters);
+        } else {
+            std::cerr << "unknown type: " << type << '\n';
+            usage(EXIT_FAILURE);
+        }
+    }
+    report.finish();
+}
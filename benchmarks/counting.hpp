@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef GFX_TIMSORT_BENCHMARK_COUNTING_HPP
+#define GFX_TIMSORT_BENCHMARK_COUNTING_HPP
+
+#include <cmath>
+#include <compare>
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bench {
+    struct operation_counts {
+        std::size_t comparisons = 0;
+        std::size_t copies = 0;
+        std::size_t moves = 0;
+    };
+
+    inline thread_local operation_counts counts;
+
+    // Wrapper counting the copies and moves of the wrapped value
+    template <typename T>
+    struct counted {
+        T value;
+
+        counted() = default;
+
+        explicit counted(T val) : value(std::move(val)) {
+        }
+
+        counted(counted const& other) : value(other.value) {
+            ++counts.copies;
+        }
+
+        counted(counted&& other) noexcept : value(std::move(other.value)) {
+            ++counts.moves;
+        }
+
+        counted& operator=(counted const& other) {
+            value = other.value;
+            ++counts.copies;
+            return *this;
+        }
+
+        counted& operator=(counted&& other) noexcept {
+            value = std::move(other.value);
+            ++counts.moves;
+            return *this;
+        }
+
+        friend bool operator==(counted const& lhs, counted const& rhs) {
+            return lhs.value == rhs.value;
+        }
+
+        friend auto operator<=>(counted const& lhs, counted const& rhs) {
+            return lhs.value <=> rhs.value;
+        }
+    };
+
+    template <typename T>
+    std::vector<counted<T>> make_counted(std::vector<T> const& values) {
+        std::vector<counted<T>> res;
+        res.reserve(values.size());
+        for (auto const& value : values) {
+            res.emplace_back(value);
+        }
+        return res;
+    }
+
+    // Comparator counting the number of times it is called
+    struct counting_less {
+        template <typename T, typename U>
+        bool operator()(T const& lhs, U const& rhs) const {
+            ++counts.comparisons;
+            return lhs < rhs;
+        }
+    };
+
+    // Resets the counters, runs the function and returns what it did
+    template <typename Run>
+    operation_counts count_operations(Run run) {
+        counts = {};
+        run();
+        return std::exchange(counts, {});
+    }
+
+    // Minimum number of comparisons needed to sort n distinct elements: log2(n!)
+    inline double sort_lower_bound(std::size_t n) {
+        return std::lgamma(static_cast<double>(n) + 1.0) / std::log(2.0);
+    }
+
+    // Minimum number of comparisons needed to merge sorted sequences of sizes m and n
+    // into one: log2((m+n)! / (m! n!))
+    inline double merge_lower_bound(std::size_t m, std::size_t n) {
+        return sort_lower_bound(m + n) - sort_lower_bound(m) - sort_lower_bound(n);
+    }
+
+    // Table of operations per element, the lower bound only has comparisons
+    inline void print_counts_header(std::ostream& out) {
+        out << std::left << std::setw(18) << "distribution" << std::setw(20) << "algorithm"
+            << std::right << std::setw(14) << "comparisons" << std::setw(10) << "moves"
+            << std::setw(10) << "copies" << "   (per element)\n";
+    }
+
+    inline void print_counts(std::ostream& out, std::string_view dist, std::string_view algo,
+                             operation_counts const& res, std::size_t size) {
+        const double n = size ? static_cast<double>(size) : 1.0;
+        out << std::left << std::setw(18) << dist << std::setw(20) << algo << std::right
+            << std::fixed << std::setprecision(3)
+            << std::setw(14) << static_cast<double>(res.comparisons) / n
+            << std::setw(10) << static_cast<double>(res.moves) / n
+            << std::setw(10) << static_cast<double>(res.copies) / n << '\n';
+    }
+
+    inline void print_lower_bound(std::ostream& out, std::string_view dist,
+                                  std::string_view name, double comparisons, std::size_t size) {
+        const double n = size ? static_cast<double>(size) : 1.0;
+        out << std::left << std::setw(18) << dist << std::setw(20) << name << std::right
+            << std::fixed << std::setprecision(3)
+            << std::setw(14) << comparisons / n << std::setw(10) << '-' << std::setw(10) << '-'
+            << '\n';
+    }
+}
+
+#endif // GFX_TIMSORT_BENCHMARK_COUNTING_HPP
@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef GFX_TIMSORT_BENCHMARK_DISTRIBUTIONS_HPP
+#define GFX_TIMSORT_BENCHMARK_DISTRIBUTIONS_HPP
+
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bench {
+    ////////////////////////////////////////////////////////////
+    // Value types
+
+    // Trivially copyable element of a given total size, ordered by its key only
+    template <std::size_t Size>
+    struct blob {
+        static_assert(Size > sizeof(std::int64_t));
+
+        std::int64_t key;
+        std::array<unsigned char, Size - sizeof(std::int64_t)> payload;
+
+        friend bool operator==(blob const& lhs, blob const& rhs) {
+            return lhs.key == rhs.key;
+        }
+
+        friend auto operator<=>(blob const& lhs, blob const& rhs) {
+            return lhs.key <=> rhs.key;
+        }
+    };
+
+    // Element of a given total size whose moves are as expensive as copies
+    // and additionally clear the moved-from payload
+    template <std::size_t Size>
+    struct heavy_move {
+        static_assert(Size > sizeof(std::int64_t));
+
+        std::int64_t key;
+        std::array<unsigned char, Size - sizeof(std::int64_t)> payload;
+
+        heavy_move() = default;
+        heavy_move(heavy_move const&) = default;
+        heavy_move& operator=(heavy_move const&) = default;
+
+        heavy_move(heavy_move&& other) noexcept :
+            key(other.key), payload(other.payload) {
+            other.payload.fill(0);
+        }
+
+        heavy_move& operator=(heavy_move&& other) noexcept {
+            key = other.key;
+            payload = other.payload;
+            other.payload.fill(0);
+            return *this;
+        }
+
+        friend bool operator==(heavy_move const& lhs, heavy_move const& rhs) {
+            return lhs.key == rhs.key;
+        }
+
+        friend auto operator<=>(heavy_move const& lhs, heavy_move const& rhs) {
+            return lhs.key <=> rhs.key;
+        }
+    };
+
+    // Pointer-to-heap element: cheap to move, but every comparison dereferences
+    // the pointers, copies clone the pointee
+    template <typename T>
+    struct boxed {
+        std::unique_ptr<T> ptr;
+
+        boxed() = default;
+        boxed(boxed&&) noexcept = default;
+        boxed& operator=(boxed&&) noexcept = default;
+
+        explicit boxed(T value) : ptr(std::make_unique<T>(std::move(value))) {
+        }
+
+        boxed(boxed const& other) : ptr(std::make_unique<T>(*other.ptr)) {
+        }
+
+        boxed& operator=(boxed const& other) {
+            ptr = std::make_unique<T>(*other.ptr);
+            return *this;
+        }
+
+        friend bool operator==(boxed const& lhs, boxed const& rhs) {
+            return *lhs.ptr == *rhs.ptr;
+        }
+
+        friend auto operator<=>(boxed const& lhs, boxed const& rhs) {
+            return *lhs.ptr <=> *rhs.ptr;
+        }
+    };
+
+    // Builds a value whose order matches the order of the given key
+    template <typename T>
+    struct make_value {
+        static T from(std::int64_t key) {
+            return static_cast<T>(key);
+        }
+    };
+
+    template <>
+    struct make_value<std::string> {
+        static std::string from(std::int64_t key) {
+            // Zero-padding keeps the lexicographic order equal to the numeric one,
+            // and the shared prefixes make comparisons realistically expensive
+            std::string digits = std::to_string(key);
+            return std::string(12 - (std::min)(digits.size(), std::size_t(12)), '0') + digits;
+        }
+    };
+
+    template <>
+    struct make_value<std::pair<int, int>> {
+        static std::pair<int, int> from(std::int64_t key) {
+            // Elements often tie on the first member and need the second one
+            return { static_cast<int>(key / 16), static_cast<int>(key % 16) };
+        }
+    };
+
+    template <std::size_t Size>
+    struct make_value<blob<Size>> {
+        static blob<Size> from(std::int64_t key) {
+            blob<Size> res;
+            res.key = key;
+            res.payload.fill(static_cast<unsigned char>(key));
+            return res;
+        }
+    };
+
+    template <std::size_t Size>
+    struct make_value<heavy_move<Size>> {
+        static heavy_move<Size> from(std::int64_t key) {
+            heavy_move<Size> res;
+            res.key = key;
+            res.payload.fill(static_cast<unsigned char>(key));
+            return res;
+        }
+    };
+
+    template <typename T>
+    struct make_value<boxed<T>> {
+        static boxed<T> from(std::int64_t key) {
+            return boxed<T>(make_value<T>::from(key));
+        }
+    };
+
+    ////////////////////////////////////////////////////////////
+    // Input distributions
+
+    enum class distribution {
+        sorted,
+        reversed,
+        shuffled,
+        sawtooth,
+        organ_pipe,
+        few_unique,
+        k_swaps,
+        random_runs,
+        random_tail,
+        ascending_noise,
+        zipf
+    };
+
+    inline constexpr distribution all_distributions[] = {
+        distribution::sorted, distribution::reversed, distribution::shuffled,
+        distribution::sawtooth, distribution::organ_pipe, distribution::few_unique,
+        distribution::k_swaps, distribution::random_runs, distribution::random_tail,
+        distribution::ascending_noise, distribution::zipf
+    };
+
+    inline constexpr std::string_view name(distribution dist) {
+        switch (dist) {
+            case distribution::sorted:          return "sorted";
+            case distribution::reversed:        return "reversed";
+            case distribution::shuffled:        return "shuffled";
+            case distribution::sawtooth:        return "sawtooth";
+            case distribution::organ_pipe:      return "organ_pipe";
+            case distribution::few_unique:      return "few_unique";
+            case distribution::k_swaps:         return "k_swaps";
+            case distribution::random_runs:     return "random_runs";
+            case distribution::random_tail:     return "random_tail";
+            case distribution::ascending_noise: return "ascending_noise";
+            case distribution::zipf:            return "zipf";
+        }
+        return "unknown";
+    }
+
+    inline std::optional<distribution> parse_distribution(std::string_view str) {
+        for (distribution dist : all_distributions) {
+            if (name(dist) == str) {
+                return dist;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Generates the keys of the given distribution, the same seed always
+    // yields the same keys
+    inline std::vector<std::int64_t> generate_keys(distribution dist, std::size_t size,
+                                                   std::uint64_t seed = 2581470) {
+        std::mt19937_64 engine(seed);
+        const auto n = static_cast<std::int64_t>(size);
+        const auto sqrt_n = (std::max)(std::int64_t(2),
+                                       static_cast<std::int64_t>(std::sqrt(double(n))));
+        const auto random_below = [&engine](std::int64_t bound) {
+            return std::uniform_int_distribution<std::int64_t>(0, bound - 1)(engine);
+        };
+
+        std::vector<std::int64_t> keys(size);
+        for (std::int64_t i = 0; i < n; ++i) {
+            keys[i] = i;
+        }
+
+        switch (dist) {
+            case distribution::sorted:
+                break;
+            case distribution::reversed:
+                std::reverse(keys.begin(), keys.end());
+                break;
+            case distribution::shuffled:
+                std::shuffle(keys.begin(), keys.end(), engine);
+                break;
+            case distribution::sawtooth:
+                // sqrt(n) ascending ramps of sqrt(n) elements
+                for (auto& key : keys) {
+                    key %= sqrt_n;
+                }
+                break;
+            case distribution::organ_pipe:
+                // Ascending first half followed by a descending second half
+                for (std::int64_t i = n / 2; i < n; ++i) {
+                    keys[i] = n - 1 - i;
+                }
+                break;
+            case distribution::few_unique:
+                for (auto& key : keys) {
+                    key = random_below(16);
+                }
+                break;
+            case distribution::k_swaps:
+                // Sorted sequence with 1% of its elements swapped at random
+                for (std::int64_t k = 0; k < n / 200 + 1 && n > 1; ++k) {
+                    std::swap(keys[random_below(n)], keys[random_below(n)]);
+                }
+                break;
+            case distribution::random_runs: {
+                // Ascending runs of random lengths in [1, 2*sqrt(n)]
+                std::shuffle(keys.begin(), keys.end(), engine);
+                for (std::int64_t i = 0; i < n;) {
+                    const std::int64_t len = (std::min)(1 + random_below(2 * sqrt_n), n - i);
+                    std::sort(keys.begin() + i, keys.begin() + i + len);
+                    i += len;
+                }
+                break;
+            }
+            case distribution::random_tail:
+                // Sorted sequence followed by 10% of random elements
+                for (std::int64_t i = n - n / 10; i < n; ++i) {
+                    keys[i] = random_below(n);
+                }
+                break;
+            case distribution::ascending_noise:
+                // Ascending sequence where each element is displaced by a small random amount
+                for (std::int64_t i = 0; i < n; ++i) {
+                    keys[i] = i + random_below(32);
+                }
+                break;
+            case distribution::zipf: {
+                // Ranks drawn with a probability proportional to 1/rank, the domain is
+                // bounded to keep the table of weights small for huge sizes
+                const std::size_t domain = (std::min)(size, std::size_t(1) << 16) + 1;
+                std::vector<double> weights(domain);
+                for (std::size_t rank = 0; rank < domain; ++rank) {
+                    weights[rank] = 1.0 / static_cast<double>(rank + 1);
+                }
+                std::discrete_distribution<std::int64_t> ranks(weights.begin(), weights.end());
+                for (auto& key : keys) {
+                    key = ranks(engine);
+                }
+                break;
+            }
+        }
+        return keys;
+    }
+
+    template <typename T>
+    std::vector<T> generate(distribution dist, std::size_t size, std::uint64_t seed = 2581470) {
+        const auto keys = generate_keys(dist, size, seed);
+        std::vector<T> res;
+        res.reserve(size);
+        for (auto key : keys) {
+            res.push_back(make_value<T>::from(key));
+        }
+        return res;
+    }
+}
+
+#endif // GFX_TIMSORT_BENCHMARK_DISTRIBUTIONS_HPP
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef GFX_TIMSORT_BENCHMARK_MEASURE_HPP
+#define GFX_TIMSORT_BENCHMARK_MEASURE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "perf_counters.hpp"
+
+namespace bench {
+    using clock = std::chrono::steady_clock;
+
+    struct timing {
+        std::size_t repetitions = 0;
+        double min_ns = 0.0;
+        double median_ns = 0.0;
+        double mean_ns = 0.0;
+        // Hardware counters per repetition, when requested and available
+        counter_values counters;
+    };
+
+    inline timing summarize(std::vector<double> samples) {
+        timing res;
+        res.repetitions = samples.size();
+        if (samples.empty()) {
+            return res;
+        }
+        std::sort(samples.begin(), samples.end());
+        const std::size_t mid = samples.size() / 2;
+        res.min_ns = samples.front();
+        res.median_ns = samples.size() % 2 ? samples[mid] : (samples[mid - 1] + samples[mid]) / 2;
+        for (double sample : samples) {
+            res.mean_ns += sample;
+        }
+        res.mean_ns /= static_cast<double>(samples.size());
+        return res;
+    }
+
+    // Calls prepare() then times run() warmups + repetitions times, only the
+    // timings of the repetitions are kept; check() is called after every run
+    // outside of the timed region. When counters are given, they are enabled
+    // around run() and their average over the repetitions is reported.
+    template <typename Prepare, typename Run, typename Check>
+    timing measure(std::size_t warmups, std::size_t repetitions,
+                   Prepare prepare, Run run, Check check,
+                   perf_counters* counters = nullptr) {
+        std::vector<double> samples;
+        samples.reserve(repetitions);
+        for (std::size_t i = 0; i < warmups + repetitions; ++i) {
+            prepare();
+            if (counters) {
+                if (i == warmups) {
+                    counters->reset();
+                }
+                counters->start();
+            }
+            const auto start = clock::now();
+            run();
+            const auto stop = clock::now();
+            if (counters) {
+                counters->stop();
+            }
+            check();
+            if (i >= warmups) {
+                samples.push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+            }
+        }
+
+        auto res = summarize(std::move(samples));
+        if (counters) {
+            res.counters = counters->read();
+            for (auto& value : res.counters) {
+                if (value) {
+                    *value /= static_cast<double>(repetitions);
+                }
+            }
+        }
+        return res;
+    }
+}
+
+#endif // GFX_TIMSORT_BENCHMARK_MEASURE_HPP
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef GFX_TIMSORT_BENCHMARK_PERF_COUNTERS_HPP
+#define GFX_TIMSORT_BENCHMARK_PERF_COUNTERS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#if defined(__linux__)
+#   include <cstring>
+#   include <linux/perf_event.h>
+#   include <sys/ioctl.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
+
+namespace bench {
+    inline constexpr std::size_t counter_count = 6;
+
+    inline constexpr std::array<std::string_view, counter_count> counter_names = {
+        "cycles", "instructions", "branch_misses", "l1d_misses", "llc_misses", "dtlb_misses"
+    };
+
+    // Value of each counter, empty when the counter could not be read
+    using counter_values = std::array<std::optional<double>, counter_count>;
+
+    // Hardware counters read with perf_event_open on Linux, counting only while
+    // enabled between start() and stop(). Counters which can't be opened, for
+    // example because of perf_event_paranoid or of a missing PMU in virtual
+    // machines, are silently left out; everywhere else no counter is available.
+    class perf_counters {
+    public:
+        perf_counters() {
+#if defined(__linux__)
+            // Read misses of the given cache
+            constexpr auto cache_misses = [](std::uint64_t cache) -> std::uint64_t {
+                return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                             | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            };
+            const std::pair<std::uint32_t, std::uint64_t> events[counter_count] = {
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+                { PERF_TYPE_HW_CACHE, cache_misses(PERF_COUNT_HW_CACHE_L1D) },
+                { PERF_TYPE_HW_CACHE, cache_misses(PERF_COUNT_HW_CACHE_LL) },
+                { PERF_TYPE_HW_CACHE, cache_misses(PERF_COUNT_HW_CACHE_DTLB) },
+            };
+            for (std::size_t i = 0; i < counter_count; ++i) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = events[i].first;
+                attr.config = events[i].second;
+                attr.disabled = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                // Scale the values when the kernel has to multiplex the counters
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            }
+#endif
+        }
+
+        perf_counters(perf_counters const&) = delete;
+        perf_counters& operator=(perf_counters const&) = delete;
+
+        ~perf_counters() {
+#if defined(__linux__)
+            for (int fd : fds_) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+#endif
+        }
+
+        // Whether at least one counter is available
+        bool available() const {
+            for (int fd : fds_) {
+                if (fd >= 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void start() {
+            control(command::enable);
+        }
+
+        void stop() {
+            control(command::disable);
+        }
+
+        void reset() {
+            control(command::reset);
+        }
+
+        // Values accumulated since the last reset
+        counter_values read() const {
+            counter_values res;
+#if defined(__linux__)
+            for (std::size_t i = 0; i < counter_count; ++i) {
+                std::uint64_t buffer[3] = {}; // value, time enabled, time running
+                if (fds_[i] < 0
+                    || ::read(fds_[i], buffer, sizeof(buffer)) != ssize_t(sizeof(buffer))) {
+                    continue;
+                }
+                double value = static_cast<double>(buffer[0]);
+                if (buffer[2] != 0 && buffer[2] < buffer[1]) {
+                    value *= static_cast<double>(buffer[1]) / static_cast<double>(buffer[2]);
+                }
+                res[i] = value;
+            }
+#endif
+            return res;
+        }
+
+    private:
+        enum class command { enable, disable, reset };
+
+        void control([[maybe_unused]] command cmd) {
+#if defined(__linux__)
+            const unsigned long request = cmd == command::enable ? PERF_EVENT_IOC_ENABLE
+                                        : cmd == command::disable ? PERF_EVENT_IOC_DISABLE
+                                        : PERF_EVENT_IOC_RESET;
+            for (int fd : fds_) {
+                if (fd >= 0) {
+                    ioctl(fd, request, 0);
+                }
+            }
+#endif
+        }
+
+        std::array<int, counter_count> fds_ = { -1, -1, -1, -1, -1, -1 };
+    };
+}
+
+#endif // GFX_TIMSORT_BENCHMARK_PERF_COUNTERS_HPP
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// The times are relative to the default constants of timsort_traits, so the tuning
+// header generated by a previous run must not replace them
+#define GFX_TIMSORT_TUNING_HPP
+#include <gfx/timsort.hpp>
+#include "distributions.hpp"
+#include "measure.hpp"
+
+// Searches the tuning constants of gfx::timsort_traits which sort a set of
+// representative value types the fastest on this machine, and writes them
+// as GFX_TIMSORT_TUNING_* macros to a header that gfx/timsort.hpp picks up
+// when it is found in the include path.
+//
+// Cheap elements (trivially copyable and no larger than two pointers) and
+// expensive ones are tuned separately, like timsort_traits distinguishes
+// them. The minimum merge size is searched first with the default galloping
+// threshold, then the galloping threshold with the best minimum merge size.
+
+namespace
+{
+    constexpr std::array<std::ptrdiff_t, 6> min_merges = { 8, 16, 24, 32, 48, 64 };
+    constexpr std::array<int, 5> min_gallops = { 3, 5, 7, 10, 14 };
+
+    // Indices of the default constants of timsort_traits
+    constexpr std::size_t cheap_default_merge = 3;     // 32
+    constexpr std::size_t expensive_default_merge = 1; // 16
+    constexpr std::size_t default_gallop = 2;          // 7
+
+    constexpr bench::distribution distributions[] = {
+        bench::distribution::shuffled, bench::distribution::sawtooth,
+        bench::distribution::few_unique, bench::distribution::k_swaps,
+        bench::distribution::random_runs, bench::distribution::zipf,
+    };
+
+    struct options {
+        std::vector<std::size_t> sizes = { 256, 4096, 65536 };
+        std::size_t repetitions = 7;
+        std::string output;
+    };
+
+    template <std::ptrdiff_t MinMerge, int MinGallop>
+    struct candidate_policy : gfx::timsort_default_policy {
+        static constexpr std::ptrdiff_t min_merge = MinMerge;
+        static constexpr int min_gallop = MinGallop;
+    };
+
+    template <typename T>
+    using sorter = void(*)(std::vector<T>&);
+
+    // Table of sorters for every pair of candidate constants
+    template <typename T, std::size_t... M, std::size_t... G>
+    constexpr auto make_sorters(std::index_sequence<M...>, std::index_sequence<G...>) {
+        auto row = [] <std::size_t I> (std::integral_constant<std::size_t, I>) {
+            return std::array<sorter<T>, sizeof...(G)>{
+                +[](std::vector<T>& vec) {
+                    using policy = candidate_policy<min_merges[I], min_gallops[G]>;
+                    gfx::timsort<policy>(vec);
+                }...
+            };
+        };
+        return std::array{ row(std::integral_constant<std::size_t, M>{})... };
+    }
+
+    template <typename T>
+    constexpr auto sorters = make_sorters<T>(std::make_index_sequence<min_merges.size()>{},
+                                             std::make_index_sequence<min_gallops.size()>{});
+
+    struct candidate {
+        std::size_t merge_index;
+        std::size_t gallop_index;
+    };
+
+    // Geometric mean over the workloads of the time of each candidate relative to
+    // the first one
+    template <typename T>
+    std::vector<double> relative_times(options const& opts, std::vector<candidate> const& cands) {
+        std::vector<double> log_sums(cands.size(), 0.0);
+        std::size_t workloads = 0;
+        for (auto dist : distributions) {
+            for (auto size : opts.sizes) {
+                const auto source = bench::generate<T>(dist, size);
+                std::vector<T> work;
+                std::vector<double> medians;
+                for (auto cand : cands) {
+                    auto sort = sorters<T>[cand.merge_index][cand.gallop_index];
+                    auto timing = bench::measure(1, opts.repetitions,
+                        [&] { work = source; },
+                        [&] { sort(work); },
+                        [&] {
+                            if (!std::is_sorted(work.begin(), work.end())) {
+                                std::cerr << "the result is not sorted\n";
+                                std::abort();
+                            }
+                        }
+                    );
+                    medians.push_back(timing.median_ns);
+                }
+                for (std::size_t i = 0; i < cands.size(); ++i) {
+                    log_sums[i] += std::log(medians[i] / medians[0]);
+                }
+                ++workloads;
+            }
+        }
+        for (auto& value : log_sums) {
+            value = std::exp(value / static_cast<double>(workloads));
+        }
+        return log_sums;
+    }
+
+    // Sum of the relative times of several types
+    template <typename... Types>
+    std::vector<double> score(options const& opts, std::vector<candidate> const& cands) {
+        std::vector<double> res(cands.size(), 0.0);
+        for (auto const& times : { relative_times<Types>(opts, cands)... }) {
+            for (std::size_t i = 0; i < cands.size(); ++i) {
+                res[i] += times[i] / sizeof...(Types);
+            }
+        }
+        return res;
+    }
+
+    struct tuning {
+        std::ptrdiff_t min_merge;
+        int min_gallop;
+        double speedup;
+    };
+
+    template <std::size_t DefaultMerge, typename... Types>
+    tuning search(options const& opts, std::string_view name) {
+        static_assert(((min_merges[DefaultMerge] == gfx::timsort_traits<Types>::min_merge)
+                       && ...));
+        static_assert(((min_gallops[default_gallop] == gfx::timsort_traits<Types>::min_gallop)
+                       && ...));
+
+        auto best_of = [&](std::vector<candidate> const& cands, auto get_value) {
+            auto scores = score<Types...>(opts, cands);
+            std::size_t best = 0;
+            for (std::size_t i = 0; i < cands.size(); ++i) {
+                std::cout << std::left << std::setw(10) << name << std::setw(14)
+                          << get_value(cands[i]) << std::right << std::setw(10)
+                          << scores[i] << '\n';
+                if (scores[i] < scores[best]) {
+                    best = i;
+                }
+            }
+            return std::pair(cands[best], scores[best]);
+        };
+
+        // The default constants come first, all the times are relative to them
+        std::cout << std::left << std::setw(10) << "elements" << std::setw(14) << "min_merge"
+                  << std::right << std::setw(10) << "time" << '\n';
+        std::vector<candidate> cands = { { DefaultMerge, default_gallop } };
+        for (std::size_t i = 0; i < min_merges.size(); ++i) {
+            if (i != DefaultMerge) {
+                cands.push_back({ i, default_gallop });
+            }
+        }
+        auto [best, best_score] = best_of(cands, [](candidate cand) {
+            return min_merges[cand.merge_index];
+        });
+
+        std::cout << '\n' << std::left << std::setw(10) << "elements" << std::setw(14)
+                  << "min_gallop" << std::right << std::setw(10) << "time" << '\n';
+        cands = { best };
+        for (std::size_t i = 0; i < min_gallops.size(); ++i) {
+            if (i != default_gallop) {
+                cands.push_back({ best.merge_index, i });
+            }
+        }
+        auto [final_best, final_score] = best_of(cands, [](candidate cand) {
+            return min_gallops[cand.gallop_index];
+        });
+        std::cout << '\n';
+
+        return {
+            min_merges[final_best.merge_index],
+            min_gallops[final_best.gallop_index],
+            1.0 / (best_score * final_score)
+        };
+    }
+
+    void write_header(std::ostream& out, tuning const& cheap, tuning const& expensive) {
+        out << std::fixed << std::setprecision(2)
+            << "/*\n"
+               " * Tuning constants of gfx::timsort_traits for the machine the autotune target of\n"
+               " * the benchmarks was run on, generated by the tuner program.\n"
+               " *\n"
+               " * Estimated speedups over the default constants: " << cheap.speedup
+            << "x for cheap elements,\n"
+               " * " << expensive.speedup << "x for expensive elements.\n"
+               " */\n\n"
+               "#ifndef GFX_TIMSORT_TUNING_HPP\n"
+               "#define GFX_TIMSORT_TUNING_HPP\n\n"
+               "// Trivially copyable elements no larger than two pointers\n"
+               "#ifndef GFX_TIMSORT_TUNING_MIN_MERGE\n"
+               "#   define GFX_TIMSORT_TUNING_MIN_MERGE " << cheap.min_merge << "\n"
+               "#endif\n"
+               "#ifndef GFX_TIMSORT_TUNING_MIN_GALLOP\n"
+               "#   define GFX_TIMSORT_TUNING_MIN_GALLOP " << cheap.min_gallop << "\n"
+               "#endif\n\n"
+               "// Other elements\n"
+               "#ifndef GFX_TIMSORT_TUNING_EXPENSIVE_MIN_MERGE\n"
+               "#   define GFX_TIMSORT_TUNING_EXPENSIVE_MIN_MERGE " << expensive.min_merge << "\n"
+               "#endif\n"
+               "#ifndef GFX_TIMSORT_TUNING_EXPENSIVE_MIN_GALLOP\n"
+               "#   define GFX_TIMSORT_TUNING_EXPENSIVE_MIN_GALLOP " << expensive.min_gallop << "\n"
+               "#endif\n\n"
+               "#endif // GFX_TIMSORT_TUNING_HPP\n";
+    }
+
+    [[noreturn]] void usage(int exit_code) {
+        std::cerr <<
+            "usage: tuner [options]\n"
+            "  --sizes=N,...     sizes of the workloads (default 256,4096,65536)\n"
+            "  --repetitions=N   timed runs per measurement (default 7)\n"
+            "  --output=FILE     write the tuning header to FILE instead of stdout\n";
+        std::exit(exit_code);
+    }
+
+    std::size_t parse_size(std::string const& str) {
+        try {
+            return static_cast<std::size_t>(std::stod(str));
+        } catch (std::exception const&) {
+            std::cerr << "invalid number: " << str << '\n';
+            usage(EXIT_FAILURE);
+        }
+    }
+
+    options parse_options(int argc, const char *argv[]) {
+        options opts;
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            auto eq = arg.find('=');
+            auto key = arg.substr(0, eq);
+            auto value = std::string(eq == std::string_view::npos ? "" : arg.substr(eq + 1));
+
+            if (key == "--help") {
+                usage(EXIT_SUCCESS);
+            } else if (key == "--sizes") {
+                opts.sizes.clear();
+                std::string_view sizes = value;
+                while (!sizes.empty()) {
+                    auto comma = sizes.find(',');
+                    opts.sizes.push_back(parse_size(std::string(sizes.substr(0, comma))));
+                    sizes.remove_prefix(comma == std::string_view::npos ? sizes.size() : comma + 1);
+                }
+            } else if (key == "--repetitions") {
+                opts.repetitions = (std::max)(parse_size(value), std::size_t(1));
+            } else if (key == "--output") {
+                opts.output = value;
+            } else {
+                std::cerr << "unknown option: " << arg << '\n';
+                usage(EXIT_FAILURE);
+            }
+        }
+        if (opts.sizes.empty()) {
+            usage(EXIT_FAILURE);
+        }
+        return opts;
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    const options opts = parse_options(argc, argv);
+
+    // Times are relative to the default constants, lower is better
+    std::cout << std::fixed << std::setprecision(3);
+    auto cheap = search<cheap_default_merge, int, double>(opts, "cheap");
+    auto expensive = search<expensive_default_merge, std::string, bench::blob<64>>(
+        opts, "expensive");
+
+    std::cout << "cheap elements: min_merge " << cheap.min_merge << ", min_gallop "
+              << cheap.min_gallop << "\nexpensive elements: min_merge " << expensive.min_merge
+              << ", min_gallop " << expensive.min_gallop << "\n\n";
+
+    if (opts.output.empty()) {
+        write_header(std::cout, cheap, expensive);
+        return EXIT_SUCCESS;
+    }
+    std::ofstream file(opts.output);
+    write_header(file, cheap, expensive);
+    if (!file) {
+        std::cerr << "could not write the tuning header to " << opts.output << '\n';
+        return EXIT_FAILURE;
+    }
+    std::cout << "tuning header written to " << opts.output << '\n';
+}
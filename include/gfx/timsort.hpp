@@ -32,9 +32,24 @@
 #define GFX_TIMSORT_HPP
 
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -61,425 +76,1049 @@
 
 #ifdef GFX_TIMSORT_ENABLE_LOG
 #   include <iostream>
-#   define GFX_TIMSORT_LOG(expr) (std::clog << "# " << __func__ << ": " << expr << std::endl)
+#   define GFX_TIMSORT_LOG(expr) \
+        (std::is_constant_evaluated() \
+            ? (void)0 \
+            : (void)(std::clog << "# " << __func__ << ": " << expr << std::endl))
 #else
 #   define GFX_TIMSORT_LOG(expr) ((void)0)
 #endif
 
+// Tuning macros, generated for the build machine by the autotune target of the
+// benchmarks, or defined by hand
+
+#if __has_include(<gfx/timsort_tuning.hpp>)
+#   include <gfx/timsort_tuning.hpp>
+#endif
+
+#ifndef GFX_TIMSORT_TUNING_MIN_MERGE
+#   define GFX_TIMSORT_TUNING_MIN_MERGE 32
+#endif
+#ifndef GFX_TIMSORT_TUNING_MIN_GALLOP
+#   define GFX_TIMSORT_TUNING_MIN_GALLOP 7
+#endif
+#ifndef GFX_TIMSORT_TUNING_EXPENSIVE_MIN_MERGE
+#   define GFX_TIMSORT_TUNING_EXPENSIVE_MIN_MERGE 16
+#endif
+#ifndef GFX_TIMSORT_TUNING_EXPENSIVE_MIN_GALLOP
+#   define GFX_TIMSORT_TUNING_EXPENSIVE_MIN_GALLOP 7
+#endif
+
 
 namespace gfx {
 
 // ---------------------------------------
-// Implementation details
+// Statistics and events
 // ---------------------------------------
 
-namespace detail {
+/**
+ * Statistics collected by the overloads of gfx::timsort and gfx::timmerge taking a
+ * timsort_stats out-parameter. The counters accumulate across calls so that a single
+ * object can aggregate the statistics of several sorts.
+ */
+struct timsort_stats {
+    // Number of calls to the comparison function
+    std::size_t comparisons = 0;
+    // Number of element moves, including moves to and from temporary storage
+    std::size_t moves = 0;
+    // Number of natural runs found, and histogram of their lengths: run_lengths[i]
+    // counts the runs whose length is in [2^i, 2^(i+1))
+    std::size_t runs = 0;
+    std::array<std::size_t, 64> run_lengths = {};
+    // Number of runs extended with binary insertion sort
+    std::size_t binary_sort_extensions = 0;
+    std::size_t merge_lo_calls = 0;
+    std::size_t merge_hi_calls = 0;
+    // Time spent in galloping mode, not measured during constant evaluation
+    std::chrono::nanoseconds galloping_time = {};
+    // Value of minGallop at the end of the last sort or merge
+    int min_gallop = 0;
+    // Peak size of the temporary heap storage used by merges, merges small enough to use
+    // the buffer of the sorting object don't count, and of the stack of pending runs
+    std::size_t peak_tmp_bytes = 0;
+    std::size_t peak_pending_bytes = 0;
+};
 
-template <typename Iterator>
-struct run {
-    using diff_t = typename std::iterator_traits<Iterator>::difference_type;
+/**
+ * Phases of the algorithm reported to hooks.
+ */
+enum class timsort_event_kind {
+    run,         // detection of a natural run
+    binary_sort, // extension of a run with binary insertion sort
+    merge,       // merge of two consecutive runs
+    gallop       // excursion in galloping mode during a merge
+};
 
-    Iterator base;
-    diff_t len;
+/**
+ * Event passed to the callbacks of hooks satisfying gfx::timsort_hooks.
+ */
+struct timsort_event {
+    timsort_event_kind kind;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+    // Position of the first element concerned, relative to the beginning of the range
+    std::ptrdiff_t offset;
+    // Length of the run, length of the extended run, length of the first merged run, or
+    // number of elements moved while galloping
+    std::ptrdiff_t length;
+    // Length of the second merged run, 0 for other events
+    std::ptrdiff_t length2;
+    // Number of runs on the stack of pending runs
+    std::size_t stack_depth;
+};
 
-    run(Iterator b, diff_t l) : base(b), len(l) {
-    }
+/**
+ * Hooks are passed by reference to gfx::timsort and gfx::timmerge, which call their
+ * member functions on_run, on_binary_sort, on_merge and on_gallop with a timsort_event
+ * at the end of the corresponding phases. Every callback is optional: no timestamp is
+ * taken for the phases without a callback. Callbacks are not called during constant
+ * evaluation.
+ */
+template <typename Hooks>
+concept timsort_hooks = requires (Hooks& hooks, timsort_event const& event) {
+        hooks.on_run(event);
+    } || requires (Hooks& hooks, timsort_event const& event) {
+        hooks.on_binary_sort(event);
+    } || requires (Hooks& hooks, timsort_event const& event) {
+        hooks.on_merge(event);
+    } || requires (Hooks& hooks, timsort_event const& event) {
+        hooks.on_gallop(event);
+    };
+
+/**
+ * Types accepted by the overloads of gfx::timsort and gfx::timmerge that observe the
+ * algorithm: timsort_stats or hooks.
+ */
+template <typename Observer>
+concept timsort_observer = std::same_as<Observer, timsort_stats> || timsort_hooks<Observer>;
+
+// ---------------------------------------
+// Tuning policies
+// ---------------------------------------
+
+/**
+ * Tuning constants of the algorithm, as found in Python's and OpenJDK's implementations.
+ * Custom policies are passed as the first template parameter of gfx::timsort and
+ * gfx::timmerge, and usually derive from this class to override some of its constants.
+ * A policy can also provide a static min_run_length(n) function to replace the
+ * computation of the minimum run length.
+ */
+struct timsort_default_policy {
+    // Ranges shorter than min_merge are sorted with binary insertion sort, longer ones
+    // are split into runs of at least min_merge to 2 * min_merge elements
+    static constexpr std::ptrdiff_t min_merge = 32;
+    // Number of consecutive wins of the same run needed to enter galloping mode at the
+    // start of a merge, and to stay in galloping mode
+    static constexpr int min_gallop = 7;
+    // Added to the galloping threshold every time galloping mode doesn't pay off
+    static constexpr int gallop_penalty = 2;
+    // Lowest galloping threshold carried over from a merge to the next one
+    static constexpr int min_gallop_floor = 1;
+    // Size of the buffer stored in the sorting object for the merges, merges that need
+    // more temporary storage than that allocate it on the heap (optional member)
+    static constexpr std::size_t merge_buffer_bytes = 1024;
 };
 
-template <typename RandomAccessIterator>
-class TimSort {
-    using iter_t = RandomAccessIterator;
-    using value_t = typename std::iterator_traits<iter_t>::value_type;
-    using diff_t = typename std::iterator_traits<iter_t>::difference_type;
+/**
+ * Requirements of the tuning policies accepted by gfx::timsort and gfx::timmerge.
+ */
+template <typename Policy>
+concept timsort_policy = requires {
+    { Policy::min_merge } -> std::convertible_to<std::ptrdiff_t>;
+    { Policy::min_gallop } -> std::convertible_to<int>;
+    { Policy::gallop_penalty } -> std::convertible_to<int>;
+    { Policy::min_gallop_floor } -> std::convertible_to<int>;
+};
 
-    static constexpr int MIN_MERGE = 32;
-    static constexpr int MIN_GALLOP = 7;
+/**
+ * Policy used when none is given explicitly, picked from the type of the elements to
+ * sort. It can be specialized for user-defined types. The constants come from the
+ * GFX_TIMSORT_TUNING_* macros, which default to the ones of timsort_default_policy.
+ */
+template <typename T>
+struct timsort_traits : timsort_default_policy {
+    static constexpr std::ptrdiff_t min_merge = GFX_TIMSORT_TUNING_MIN_MERGE;
+    static constexpr int min_gallop = GFX_TIMSORT_TUNING_MIN_GALLOP;
+};
 
-    int minGallop_ = MIN_GALLOP;
-    std::vector<value_t> tmp_; // temp storage for merges
-    std::vector<run<RandomAccessIterator>> pending_;
+/**
+ * Elements which are expensive to move or to compare make the quadratic number of moves
+ * of binary insertion sort costlier: shorter runs are built before merging them.
+ */
+template <typename T>
+    requires (!std::is_trivially_copyable_v<T> || sizeof(T) > 2 * sizeof(void*))
+struct timsort_traits<T> : timsort_default_policy {
+    static constexpr std::ptrdiff_t min_merge = GFX_TIMSORT_TUNING_EXPENSIVE_MIN_MERGE;
+    static constexpr int min_gallop = GFX_TIMSORT_TUNING_EXPENSIVE_MIN_GALLOP;
+};
 
-    template <typename Compare, typename Projection>
-    static void binarySort(iter_t const lo, iter_t const hi, iter_t start,
-                           Compare comp, Projection proj) {
-        GFX_TIMSORT_ASSERT(lo <= start);
-        GFX_TIMSORT_ASSERT(start <= hi);
-        if (start == lo) {
-            ++start;
-        }
-        for (; start < hi; ++start) {
-            GFX_TIMSORT_ASSERT(lo <= start);
-            auto pos = std::ranges::upper_bound(lo, start, std::invoke(proj, *start), comp, proj);
-            rotateRight(pos, std::ranges::next(start));
-        }
+// ---------------------------------------
+// Implementation details
+// ---------------------------------------
+
+namespace detail {
+
+// Statistics and events recorder used when neither statistics nor hooks are requested:
+// all the calls compile away
+template <typename Policy>
+struct stats_recorder {
+    template <typename Compare>
+    static constexpr Compare countComparisons(Compare comp) {
+        return comp;
     }
 
-    template <typename Compare, typename Projection>
-    static diff_t countRunAndMakeAscending(iter_t const lo, iter_t const hi,
-                                           Compare comp, Projection proj) {
-        GFX_TIMSORT_ASSERT(lo < hi);
+    constexpr void addMoves(std::ptrdiff_t) const {}
+    constexpr void addMergeLo() const {}
+    constexpr void addMergeHi() const {}
+    constexpr void setMinGallop(int) const {}
+    constexpr void updateTmpBytes(std::size_t) const {}
+    constexpr void updatePendingBytes(std::size_t) const {}
 
-        auto runHi = std::ranges::next(lo);
-        if (runHi == hi) {
-            return 1;
-        }
+    constexpr int startRun() const { return 0; }
+    constexpr int startBinarySort() const { return 0; }
+    constexpr int startMerge() const { return 0; }
+    constexpr int startGalloping() const { return 0; }
+    constexpr void finishRun(int, std::ptrdiff_t, std::ptrdiff_t, std::size_t) const {}
+    constexpr void finishBinarySort(int, std::ptrdiff_t, std::ptrdiff_t, std::size_t) const {}
+    constexpr void finishMerge(int, std::ptrdiff_t, std::ptrdiff_t, std::ptrdiff_t,
+                               std::size_t) const {}
+    constexpr void finishGalloping(int, std::ptrdiff_t, std::ptrdiff_t, std::size_t) const {}
+};
 
-        if (std::invoke(comp, std::invoke(proj, *runHi), std::invoke(proj, *lo))) { // decreasing
-            do {
-                ++runHi;
-            } while (runHi < hi && std::invoke(comp,
-                                               std::invoke(proj, *runHi),
-                                               std::invoke(proj, *std::ranges::prev(runHi))));
-            std::ranges::reverse(lo, runHi);
-        } else { // non-decreasing
-            do {
-                ++runHi;
-            } while (runHi < hi && !std::invoke(comp,
-                                                std::invoke(proj, *runHi),
-                                                std::invoke(proj, *std::ranges::prev(runHi))));
-        }
+using event_clock = std::chrono::steady_clock;
 
-        return runHi - lo;
+constexpr event_clock::time_point now() {
+    if (std::is_constant_evaluated()) {
+        return {};
     }
+    return event_clock::now();
+}
 
-    static diff_t minRunLength(diff_t n) {
-        GFX_TIMSORT_ASSERT(n >= 0);
+template <>
+struct stats_recorder<timsort_stats> : stats_recorder<void> {
+    timsort_stats* stats;
 
-        diff_t r = 0;
-        while (n >= 2 * MIN_MERGE) {
-            r |= (n & 1);
-            n >>= 1;
-        }
-        return n + r;
+    template <typename Compare>
+    constexpr auto countComparisons(Compare comp) const {
+        return [comp = std::move(comp), stats = stats](auto&& lhs, auto&& rhs) mutable -> bool
+            requires std::invocable<Compare&, decltype(lhs), decltype(rhs)>
+        {
+            ++stats->comparisons;
+            return std::invoke(comp, std::forward<decltype(lhs)>(lhs),
+                               std::forward<decltype(rhs)>(rhs));
+        };
     }
 
-    void pushRun(iter_t const runBase, diff_t const runLen) {
-        pending_.emplace_back(runBase, runLen);
+    constexpr void addMoves(std::ptrdiff_t n) const {
+        stats->moves += static_cast<std::size_t>(n);
     }
 
-    template <typename Compare, typename Projection>
-    void mergeCollapse(Compare comp, Projection proj) {
-        while (pending_.size() > 1) {
-            diff_t n = pending_.size() - 2;
+    constexpr void addMergeLo() const {
+        ++stats->merge_lo_calls;
+    }
 
-            if ((n > 0 && pending_[n - 1].len <= pending_[n].len + pending_[n + 1].len) ||
-                (n > 1 && pending_[n - 2].len <= pending_[n - 1].len + pending_[n].len)) {
-                if (pending_[n - 1].len < pending_[n + 1].len) {
-                    --n;
-                }
-                mergeAt(n, comp, proj);
-            } else if (pending_[n].len <= pending_[n + 1].len) {
-                mergeAt(n, comp, proj);
-            } else {
-                break;
-            }
-        }
+    constexpr void addMergeHi() const {
+        ++stats->merge_hi_calls;
     }
 
-    template <typename Compare, typename Projection>
-    void mergeForceCollapse(Compare comp, Projection proj) {
-        while (pending_.size() > 1) {
-            diff_t n = pending_.size() - 2;
+    constexpr void setMinGallop(int minGallop) const {
+        stats->min_gallop = minGallop;
+    }
 
-            if (n > 0 && pending_[n - 1].len < pending_[n + 1].len) {
-                --n;
-            }
-            mergeAt(n, comp, proj);
-        }
+    constexpr void updateTmpBytes(std::size_t bytes) const {
+        stats->peak_tmp_bytes = (std::max)(stats->peak_tmp_bytes, bytes);
     }
 
-    template <typename Compare, typename Projection>
-    void mergeAt(diff_t const i, Compare comp, Projection proj) {
-        diff_t const stackSize = pending_.size();
-        GFX_TIMSORT_ASSERT(stackSize >= 2);
-        GFX_TIMSORT_ASSERT(i >= 0);
-        GFX_TIMSORT_ASSERT(i == stackSize - 2 || i == stackSize - 3);
+    constexpr void updatePendingBytes(std::size_t bytes) const {
+        stats->peak_pending_bytes = (std::max)(stats->peak_pending_bytes, bytes);
+    }
+
+    constexpr void finishRun(int, std::ptrdiff_t, std::ptrdiff_t len, std::size_t) const {
+        ++stats->runs;
+        ++stats->run_lengths[std::bit_width(static_cast<std::size_t>(len)) - 1];
+    }
 
-        auto base1 = pending_[i].base;
-        auto len1 = pending_[i].len;
-        auto base2 = pending_[i + 1].base;
-        auto len2 = pending_[i + 1].len;
+    constexpr void finishBinarySort(int, std::ptrdiff_t, std::ptrdiff_t, std::size_t) const {
+        ++stats->binary_sort_extensions;
+    }
 
-        pending_[i].len = len1 + len2;
+    constexpr event_clock::time_point startGalloping() const {
+        return now();
+    }
 
-        if (i == stackSize - 3) {
-            pending_[i + 1] = pending_[i + 2];
+    constexpr void finishGalloping(event_clock::time_point start,
+                                   std::ptrdiff_t, std::ptrdiff_t, std::size_t) const {
+        if (!std::is_constant_evaluated()) {
+            stats->galloping_time += event_clock::now() - start;
         }
+    }
+};
 
-        pending_.pop_back();
+// Events recorder forwarding the events to user hooks: only the phases observed by
+// the hooks are timestamped
+template <timsort_hooks Hooks>
+struct stats_recorder<Hooks> : stats_recorder<void> {
+    Hooks* hooks;
 
-        mergeConsecutiveRuns(base1, len1, base2, len2, std::move(comp), std::move(proj));
-    }
+    static constexpr bool observesRun = requires (Hooks& h, timsort_event const& event) {
+        h.on_run(event);
+    };
+    static constexpr bool observesBinarySort = requires (Hooks& h, timsort_event const& event) {
+        h.on_binary_sort(event);
+    };
+    static constexpr bool observesMerge = requires (Hooks& h, timsort_event const& event) {
+        h.on_merge(event);
+    };
+    static constexpr bool observesGallop = requires (Hooks& h, timsort_event const& event) {
+        h.on_gallop(event);
+    };
 
-    template <typename Compare, typename Projection>
-    void mergeConsecutiveRuns(iter_t base1, diff_t len1, iter_t base2, diff_t len2,
-                              Compare comp, Projection proj) {
-        GFX_TIMSORT_ASSERT(len1 > 0);
-        GFX_TIMSORT_ASSERT(len2 > 0);
-        GFX_TIMSORT_ASSERT(base1 + len1 == base2);
+    template <bool Observed>
+    using timestamp = std::conditional_t<Observed, event_clock::time_point, int>;
 
-        auto k = gallopRight(std::invoke(proj, *base2), base1, len1, 0, comp, proj);
-        GFX_TIMSORT_ASSERT(k >= 0);
+    template <bool Observed>
+    static constexpr timestamp<Observed> start() {
+        if constexpr (Observed) {
+            return now();
+        } else {
+            return 0;
+        }
+    }
 
-        base1 += k;
-        len1 -= k;
+    constexpr auto startRun() const { return start<observesRun>(); }
+    constexpr auto startBinarySort() const { return start<observesBinarySort>(); }
+    constexpr auto startMerge() const { return start<observesMerge>(); }
+    constexpr auto startGalloping() const { return start<observesGallop>(); }
 
-        if (len1 == 0) {
-            return;
+    constexpr void finishRun(timestamp<observesRun> startTime, std::ptrdiff_t offset,
+                             std::ptrdiff_t len, std::size_t depth) const {
+        if constexpr (observesRun) {
+            if (!std::is_constant_evaluated()) {
+                hooks->on_run(timsort_event{
+                    timsort_event_kind::run, startTime, event_clock::now(),
+                    offset, len, 0, depth
+                });
+            }
         }
+    }
 
-        len2 = gallopLeft(std::invoke(proj, base1[len1 - 1]), base2, len2, len2 - 1, comp, proj);
-        GFX_TIMSORT_ASSERT(len2 >= 0);
-        if (len2 == 0) {
-            return;
+    constexpr void finishBinarySort(timestamp<observesBinarySort> startTime,
+                                    std::ptrdiff_t offset, std::ptrdiff_t len,
+                                    std::size_t depth) const {
+        if constexpr (observesBinarySort) {
+            if (!std::is_constant_evaluated()) {
+                hooks->on_binary_sort(timsort_event{
+                    timsort_event_kind::binary_sort, startTime, event_clock::now(),
+                    offset, len, 0, depth
+                });
+            }
         }
+    }
 
-        if (len1 <= len2) {
-            mergeLo(base1, len1, base2, len2, comp, proj);
-        } else {
-            mergeHi(base1, len1, base2, len2, comp, proj);
+    constexpr void finishMerge(timestamp<observesMerge> startTime, std::ptrdiff_t offset,
+                               std::ptrdiff_t len1, std::ptrdiff_t len2, std::size_t depth) const {
+        if constexpr (observesMerge) {
+            if (!std::is_constant_evaluated()) {
+                hooks->on_merge(timsort_event{
+                    timsort_event_kind::merge, startTime, event_clock::now(),
+                    offset, len1, len2, depth
+                });
+            }
         }
     }
 
-    template <typename T, typename Iter, typename Compare, typename Projection>
-    static diff_t gallopLeft(T const& key, Iter const base, diff_t const len, diff_t const hint,
-                             Compare comp, Projection proj) {
-        GFX_TIMSORT_ASSERT(len > 0);
-        GFX_TIMSORT_ASSERT(hint >= 0);
-        GFX_TIMSORT_ASSERT(hint < len);
+    constexpr void finishGalloping(timestamp<observesGallop> startTime, std::ptrdiff_t offset,
+                                   std::ptrdiff_t len, std::size_t depth) const {
+        if constexpr (observesGallop) {
+            if (!std::is_constant_evaluated()) {
+                hooks->on_gallop(timsort_event{
+                    timsort_event_kind::gallop, startTime, event_clock::now(),
+                    offset, len, 0, depth
+                });
+            }
+        }
+    }
+};
 
-        diff_t lastOfs = 0;
-        diff_t ofs = 1;
+// Returns the position of the first element of [base, base + len) not less than
+// key, searching exponentially outwards from base + hint first
+template <typename T, typename Iter, typename Compare, typename Projection>
+constexpr std::iter_difference_t<Iter> gallopLeft(T const& key, Iter const base,
+                                                  std::iter_difference_t<Iter> const len,
+                                                  std::iter_difference_t<Iter> const hint,
+                                                  Compare comp, Projection proj) {
+    using diff_t = std::iter_difference_t<Iter>;
 
-        if (std::invoke(comp, std::invoke(proj, base[hint]), key)) {
-            auto maxOfs = len - hint;
-            while (ofs < maxOfs && std::invoke(comp, std::invoke(proj, base[hint + ofs]), key)) {
-                lastOfs = ofs;
-                ofs = (ofs << 1) + 1;
+    GFX_TIMSORT_ASSERT(len > 0);
+    GFX_TIMSORT_ASSERT(hint >= 0);
+    GFX_TIMSORT_ASSERT(hint < len);
 
-                if (ofs <= 0) { // int overflow
-                    ofs = maxOfs;
-                }
-            }
-            if (ofs > maxOfs) {
+    diff_t lastOfs = 0;
+    diff_t ofs = 1;
+
+    if (std::invoke(comp, std::invoke(proj, base[hint]), key)) {
+        auto maxOfs = len - hint;
+        while (ofs < maxOfs && std::invoke(comp, std::invoke(proj, base[hint + ofs]), key)) {
+            lastOfs = ofs;
+            ofs = (ofs << 1) + 1;
+
+            if (ofs <= 0) { // int overflow
                 ofs = maxOfs;
             }
+        }
+        if (ofs > maxOfs) {
+            ofs = maxOfs;
+        }
 
-            lastOfs += hint;
-            ofs += hint;
-        } else {
-            diff_t const maxOfs = hint + 1;
-            while (ofs < maxOfs && !std::invoke(comp, std::invoke(proj, base[hint - ofs]), key)) {
-                lastOfs = ofs;
-                ofs = (ofs << 1) + 1;
+        lastOfs += hint;
+        ofs += hint;
+    } else {
+        diff_t const maxOfs = hint + 1;
+        while (ofs < maxOfs && !std::invoke(comp, std::invoke(proj, base[hint - ofs]), key)) {
+            lastOfs = ofs;
+            ofs = (ofs << 1) + 1;
 
-                if (ofs <= 0) {
-                    ofs = maxOfs;
-                }
-            }
-            if (ofs > maxOfs) {
+            if (ofs <= 0) {
                 ofs = maxOfs;
             }
-
-            diff_t const tmp = lastOfs;
-            lastOfs = hint - ofs;
-            ofs = hint - tmp;
         }
-        GFX_TIMSORT_ASSERT(-1 <= lastOfs);
-        GFX_TIMSORT_ASSERT(lastOfs < ofs);
-        GFX_TIMSORT_ASSERT(ofs <= len);
+        if (ofs > maxOfs) {
+            ofs = maxOfs;
+        }
 
-        return std::ranges::lower_bound(base + (lastOfs + 1), base + ofs, key, comp, proj) - base;
+        diff_t const tmp = lastOfs;
+        lastOfs = hint - ofs;
+        ofs = hint - tmp;
     }
+    GFX_TIMSORT_ASSERT(-1 <= lastOfs);
+    GFX_TIMSORT_ASSERT(lastOfs < ofs);
+    GFX_TIMSORT_ASSERT(ofs <= len);
 
-    template <typename T, typename Iter, typename Compare, typename Projection>
-    static diff_t gallopRight(T const& key, Iter const base, diff_t const len, diff_t const hint,
-                              Compare comp, Projection proj) {
-        GFX_TIMSORT_ASSERT(len > 0);
-        GFX_TIMSORT_ASSERT(hint >= 0);
-        GFX_TIMSORT_ASSERT(hint < len);
+    return std::ranges::lower_bound(base + (lastOfs + 1), base + ofs, key, comp, proj) - base;
+}
 
-        diff_t ofs = 1;
-        diff_t lastOfs = 0;
+// Returns the position of the first element of [base, base + len) greater than
+// key, searching exponentially outwards from base + hint first
+template <typename T, typename Iter, typename Compare, typename Projection>
+constexpr std::iter_difference_t<Iter> gallopRight(T const& key, Iter const base,
+                                                   std::iter_difference_t<Iter> const len,
+                                                   std::iter_difference_t<Iter> const hint,
+                                                   Compare comp, Projection proj) {
+    using diff_t = std::iter_difference_t<Iter>;
 
-        if (std::invoke(comp, key, std::invoke(proj, base[hint]))) {
-            diff_t const maxOfs = hint + 1;
-            while (ofs < maxOfs && std::invoke(comp, key, std::invoke(proj, base[hint - ofs]))) {
-                lastOfs = ofs;
-                ofs = (ofs << 1) + 1;
+    GFX_TIMSORT_ASSERT(len > 0);
+    GFX_TIMSORT_ASSERT(hint >= 0);
+    GFX_TIMSORT_ASSERT(hint < len);
 
-                if (ofs <= 0) {
-                    ofs = maxOfs;
-                }
-            }
-            if (ofs > maxOfs) {
+    diff_t ofs = 1;
+    diff_t lastOfs = 0;
+
+    if (std::invoke(comp, key, std::invoke(proj, base[hint]))) {
+        diff_t const maxOfs = hint + 1;
+        while (ofs < maxOfs && std::invoke(comp, key, std::invoke(proj, base[hint - ofs]))) {
+            lastOfs = ofs;
+            ofs = (ofs << 1) + 1;
+
+            if (ofs <= 0) {
                 ofs = maxOfs;
             }
+        }
+        if (ofs > maxOfs) {
+            ofs = maxOfs;
+        }
 
-            diff_t const tmp = lastOfs;
-            lastOfs = hint - ofs;
-            ofs = hint - tmp;
-        } else {
-            diff_t const maxOfs = len - hint;
-            while (ofs < maxOfs && !std::invoke(comp, key, std::invoke(proj, base[hint + ofs]))) {
-                lastOfs = ofs;
-                ofs = (ofs << 1) + 1;
+        diff_t const tmp = lastOfs;
+        lastOfs = hint - ofs;
+        ofs = hint - tmp;
+    } else {
+        diff_t const maxOfs = len - hint;
+        while (ofs < maxOfs && !std::invoke(comp, key, std::invoke(proj, base[hint + ofs]))) {
+            lastOfs = ofs;
+            ofs = (ofs << 1) + 1;
 
-                if (ofs <= 0) { // int overflow
-                    ofs = maxOfs;
-                }
-            }
-            if (ofs > maxOfs) {
+            if (ofs <= 0) { // int overflow
                 ofs = maxOfs;
             }
-
-            lastOfs += hint;
-            ofs += hint;
         }
-        GFX_TIMSORT_ASSERT(-1 <= lastOfs);
-        GFX_TIMSORT_ASSERT(lastOfs < ofs);
-        GFX_TIMSORT_ASSERT(ofs <= len);
+        if (ofs > maxOfs) {
+            ofs = maxOfs;
+        }
 
-        return std::ranges::upper_bound(base + (lastOfs + 1), base + ofs, key, comp, proj) - base;
+        lastOfs += hint;
+        ofs += hint;
     }
+    GFX_TIMSORT_ASSERT(-1 <= lastOfs);
+    GFX_TIMSORT_ASSERT(lastOfs < ofs);
+    GFX_TIMSORT_ASSERT(ofs <= len);
 
-    static void rotateLeft(iter_t first, iter_t last) {
-        auto tmp = std::ranges::iter_move(first);
-        auto [_, last_1] = std::ranges::move(std::ranges::next(first), last, first);
-        *last_1 = std::move(tmp);
-    }
+    return std::ranges::upper_bound(base + (lastOfs + 1), base + ofs, key, comp, proj) - base;
+}
 
-    static void rotateRight(iter_t first, iter_t last) {
-        auto last_1 = std::ranges::prev(last);
-        auto tmp = std::ranges::iter_move(last_1);
-        std::ranges::move_backward(first, last_1, last);
-        *first = std::move(tmp);
-    }
+// Number of elements of the ranges whose size is part of their type, -1 otherwise
+template <typename Range>
+inline constexpr std::ptrdiff_t static_size = -1;
 
-    template <typename Compare, typename Projection>
-    void mergeLo(iter_t const base1, diff_t len1, iter_t const base2, diff_t len2,
-                 Compare comp, Projection proj) {
-        GFX_TIMSORT_ASSERT(len1 > 0);
-        GFX_TIMSORT_ASSERT(len2 > 0);
-        GFX_TIMSORT_ASSERT(base1 + len1 == base2);
+template <typename T, std::size_t N>
+inline constexpr std::ptrdiff_t static_size<T[N]> = static_cast<std::ptrdiff_t>(N);
 
-        if (len1 == 1) {
-            return rotateLeft(base1, base2 + len2);
+template <typename T, std::size_t N>
+inline constexpr std::ptrdiff_t static_size<std::array<T, N>> = static_cast<std::ptrdiff_t>(N);
+
+template <typename T, std::size_t N>
+    requires (N != std::dynamic_extent)
+inline constexpr std::ptrdiff_t static_size<std::span<T, N>> = static_cast<std::ptrdiff_t>(N);
+
+// Whether moving elements from In to Out can be done by copying their bytes
+template <typename In, typename Out>
+inline constexpr bool bitwise_movable =
+    std::contiguous_iterator<In> && std::contiguous_iterator<Out>
+    && std::same_as<std::iter_value_t<In>, std::iter_value_t<Out>>
+    && std::is_trivially_copyable_v<std::iter_value_t<In>>;
+
+// std::ranges::move, with a memmove of trivially copyable elements between
+// contiguous ranges, which may overlap
+template <typename In, typename Out>
+constexpr Out moveRange(In first, In last, Out out) {
+    if constexpr (bitwise_movable<In, Out>) {
+        if (!std::is_constant_evaluated()) {
+            auto const len = last - first;
+            if (len > 0) {
+                std::memmove(std::to_address(out), std::to_address(first),
+                             static_cast<std::size_t>(len) * sizeof(std::iter_value_t<In>));
+            }
+            return out + len;
         }
-        if (len2 == 1) {
-            return rotateRight(base1, base2 + len2);
+    }
+    return std::ranges::move(first, last, out).out;
+}
+
+// std::ranges::move_backward, with a memmove of trivially copyable elements
+// between contiguous ranges, which may overlap
+template <typename In, typename Out>
+constexpr Out moveRangeBackward(In first, In last, Out outLast) {
+    if constexpr (bitwise_movable<In, Out>) {
+        if (!std::is_constant_evaluated()) {
+            auto const len = last - first;
+            if (len > 0) {
+                std::memmove(std::to_address(outLast - len), std::to_address(first),
+                             static_cast<std::size_t>(len) * sizeof(std::iter_value_t<In>));
+            }
+            return outLast - len;
         }
+    }
+    return std::ranges::move_backward(first, last, outLast).out;
+}
 
-        move_to_tmp(base1, len1);
+// Raw storage for the elements moved out of the range during the merges. The elements
+// stay alive from a merge to the next one and are move-assigned over, instead of being
+// destroyed and move-constructed again every time; they are only destroyed when the
+// storage grows or is released. Trivially copyable elements are copied as bytes.
+// Merges of up to InlineBytes bytes use storage inside the object instead of the heap,
+// except during constant evaluation.
+template <typename T, std::size_t InlineBytes = 0>
+class merge_buffer {
+    static constexpr std::size_t inline_capacity = InlineBytes / sizeof(T);
+    static constexpr bool bitwise = std::is_trivially_copyable_v<T>;
 
-        auto cursor1 = tmp_.begin();
-        auto cursor2 = base2;
-        auto dest = base1;
+    struct inline_storage {
+        alignas(T) std::byte bytes[inline_capacity * sizeof(T)];
+    };
+    struct no_inline_storage {};
 
-        *dest = std::ranges::iter_move(cursor2);
-        ++cursor2;
-        ++dest;
-        --len2;
+    T* data_ = nullptr;
+    std::size_t size_ = 0; // number of live elements
+    std::size_t capacity_ = 0;
+    [[no_unique_address]] std::conditional_t<
+        inline_capacity != 0, inline_storage, no_inline_storage
+    > inline_;
 
-        int minGallop(minGallop_);
+    // The inline storage is never used during constant evaluation, and the heap
+    // storage is only used for more elements than fit in the inline storage otherwise
+    constexpr bool isInline() const {
+        return !std::is_constant_evaluated() && capacity_ <= inline_capacity;
+    }
 
-        // outer:
-        while (true) {
-            diff_t count1 = 0;
-            diff_t count2 = 0;
+public:
+    constexpr merge_buffer() {
+    }
 
-            do {
-                GFX_TIMSORT_ASSERT(len1 > 1);
-                GFX_TIMSORT_ASSERT(len2 > 0);
+    merge_buffer(merge_buffer const&) = delete;
+    merge_buffer& operator=(merge_buffer const&) = delete;
 
-                if (std::invoke(comp, std::invoke(proj, *cursor2), std::invoke(proj, *cursor1))) {
-                    *dest = std::ranges::iter_move(cursor2);
-                    ++cursor2;
-                    ++dest;
-                    ++count2;
-                    count1 = 0;
-                    if (--len2 == 0) {
-                        goto epilogue;
-                    }
-                } else {
-                    *dest = std::ranges::iter_move(cursor1);
-                    ++cursor1;
-                    ++dest;
-                    ++count1;
-                    count2 = 0;
-                    if (--len1 == 1) {
-                        goto epilogue;
-                    }
-                }
-            } while ((count1 | count2) < minGallop);
+    constexpr ~merge_buffer() {
+        release();
+    }
 
-            do {
-                GFX_TIMSORT_ASSERT(len1 > 1);
-                GFX_TIMSORT_ASSERT(len2 > 0);
+    constexpr T* data() const {
+        return data_;
+    }
 
-                count1 = gallopRight(std::invoke(proj, *cursor2), cursor1, len1, 0, comp, proj);
-                if (count1 != 0) {
-                    std::ranges::move_backward(cursor1, cursor1 + count1, dest + count1);
-                    dest += count1;
-                    cursor1 += count1;
-                    len1 -= count1;
+    constexpr std::size_t capacity() const {
+        return capacity_;
+    }
 
-                    if (len1 <= 1) {
-                        goto epilogue;
-                    }
-                }
-                *dest = std::ranges::iter_move(cursor2);
-                ++cursor2;
-                ++dest;
-                if (--len2 == 0) {
-                    goto epilogue;
+    // Bytes of heap storage currently allocated
+    constexpr std::size_t heapBytes() const {
+        return data_ != nullptr && !isInline() ? capacity_ * sizeof(T) : 0;
+    }
+
+    // Makes room for count elements, destroying the live ones if the storage has to grow
+    constexpr void reserve(std::size_t const count) {
+        if (count > capacity_) {
+            release();
+            if constexpr (inline_capacity != 0) {
+                if (!std::is_constant_evaluated() && count <= inline_capacity) {
+                    data_ = reinterpret_cast<T*>(inline_.bytes);
+                    capacity_ = inline_capacity;
                 }
+            }
+            if (data_ == nullptr) {
+                data_ = std::allocator<T>().allocate(count);
+                capacity_ = count;
+            }
+        }
+    }
 
-                count2 = gallopLeft(std::invoke(proj, *cursor1), cursor2, len2, 0, comp, proj);
-                if (count2 != 0) {
-                    std::ranges::move(cursor2, cursor2 + count2, dest);
-                    dest += count2;
-                    cursor2 += count2;
-                    len2 -= count2;
-                    if (len2 == 0) {
-                        goto epilogue;
-                    }
-                }
-                *dest = std::ranges::iter_move(cursor1);
-                ++cursor1;
-                ++dest;
-                if (--len1 == 1) {
-                    goto epilogue;
+    // Moves the len elements starting at first to the beginning of the storage
+    template <typename Iter>
+    constexpr T* assign(Iter first, std::iter_difference_t<Iter> const len) {
+        auto const count = static_cast<std::size_t>(len);
+        reserve(count);
+
+        if constexpr (bitwise && bitwise_movable<Iter, T*>) {
+            if (!std::is_constant_evaluated()) {
+                moveRange(first, first + len, data_);
+                return data_;
+            }
+        }
+
+        // Move-assign over the live elements, then move-construct the rest
+        auto const live = (std::min)(count, size_);
+        std::ranges::move(first, first + live, data_);
+        for (std::size_t i = live; i < count; ++i) {
+            std::construct_at(data_ + i, std::ranges::iter_move(first + i));
+            ++size_;
+        }
+        return data_;
+    }
+
+    constexpr void release() {
+        if (data_ != nullptr) {
+            std::destroy(data_, data_ + size_);
+            if (!isInline()) {
+                std::allocator<T>().deallocate(data_, capacity_);
+            }
+            data_ = nullptr;
+            size_ = 0;
+            capacity_ = 0;
+        }
+    }
+};
+
+template <typename Iterator>
+struct run {
+    using diff_t = typename std::iterator_traits<Iterator>::difference_type;
+
+    Iterator base;
+    diff_t len;
+
+    run() = default;
+
+    constexpr run(Iterator b, diff_t l) : base(b), len(l) {
+    }
+};
+
+// Upper bound of the number of runs simultaneously on the stack when sorting n
+// elements: the invariants maintained by mergeCollapse make the lengths of the runs
+// grow at least as fast as the Fibonacci sequence from the top of the stack down
+template <typename Diff>
+constexpr Diff maxPendingRuns(Diff n, Diff const minRun) {
+    Diff count = 1; // the run pushed right before a collapse
+    Diff prevLen = 0;
+    Diff len = minRun;
+    while (n >= len) {
+        n -= len;
+        ++count;
+        Diff const nextLen = prevLen + len;
+        prevLen = len;
+        len = nextLen;
+    }
+    return count;
+}
+
+// Stack of pending runs stored in the sorting object, large enough for runs of a
+// single element over the largest possible ranges
+template <typename Iterator>
+class run_stack {
+    using diff_t = typename std::iterator_traits<Iterator>::difference_type;
+
+    static constexpr auto capacity =
+        static_cast<std::size_t>(maxPendingRuns((std::numeric_limits<diff_t>::max)(), diff_t(1)));
+
+    std::array<run<Iterator>, capacity> runs_;
+    std::size_t size_ = 0;
+
+public:
+    constexpr std::size_t size() const {
+        return size_;
+    }
+
+    constexpr run<Iterator>& operator[](std::size_t i) {
+        GFX_TIMSORT_ASSERT(i < size_);
+        return runs_[i];
+    }
+
+    constexpr void emplace_back(Iterator base, diff_t len) {
+        GFX_TIMSORT_ASSERT(size_ < capacity);
+        runs_[size_] = run<Iterator>(base, len);
+        ++size_;
+    }
+
+    constexpr void pop_back() {
+        GFX_TIMSORT_ASSERT(size_ > 0);
+        --size_;
+    }
+
+    constexpr void clear() {
+        size_ = 0;
+    }
+
+    // Replaces the runs i and i + 1, i being one of the two runs below the top of the
+    // stack, with a single run spanning both, and returns them
+    constexpr std::pair<run<Iterator>, run<Iterator>> joinAt(std::size_t const i) {
+        GFX_TIMSORT_ASSERT(size_ >= 2);
+        GFX_TIMSORT_ASSERT(i == size_ - 2 || i == size_ - 3);
+
+        auto const runs = std::pair(runs_[i], runs_[i + 1]);
+        runs_[i].len = runs.first.len + runs.second.len;
+        if (i == size_ - 3) {
+            runs_[i + 1] = runs_[i + 2];
+        }
+        pop_back();
+        return runs;
+    }
+
+    // Calls mergeAt(i) to merge runs i and i + 1 until the lengths of the runs satisfy the
+    // invariants of TimSort, which bound the number of pending runs: every run is longer
+    // than the one above it, and longer than the two above it put together
+    template <typename MergeAt>
+    constexpr void collapse(MergeAt mergeAt) {
+        while (size_ > 1) {
+            std::size_t n = size_ - 2;
+
+            if ((n > 0 && runs_[n - 1].len <= runs_[n].len + runs_[n + 1].len) ||
+                (n > 1 && runs_[n - 2].len <= runs_[n - 1].len + runs_[n].len)) {
+                if (runs_[n - 1].len < runs_[n + 1].len) {
+                    --n;
                 }
+                mergeAt(n);
+            } else if (runs_[n].len <= runs_[n + 1].len) {
+                mergeAt(n);
+            } else {
+                break;
+            }
+        }
+    }
 
-                --minGallop;
-            } while ((count1 >= MIN_GALLOP) | (count2 >= MIN_GALLOP));
+    // Calls mergeAt(i) to merge runs i and i + 1 until a single run is left
+    template <typename MergeAt>
+    constexpr void forceCollapse(MergeAt mergeAt) {
+        while (size_ > 1) {
+            std::size_t n = size_ - 2;
 
-            if (minGallop < 0) {
-                minGallop = 0;
+            if (n > 0 && runs_[n - 1].len < runs_[n + 1].len) {
+                --n;
             }
-            minGallop += 2;
-        } // end of "outer" loop
+            mergeAt(n);
+        }
+    }
+};
+
+// Size of the merge buffer stored in the sorting objects for a policy
+template <typename Policy>
+inline constexpr std::size_t merge_buffer_bytes = [] {
+    if constexpr (requires { Policy::merge_buffer_bytes; }) {
+        return static_cast<std::size_t>(Policy::merge_buffer_bytes);
+    } else {
+        return timsort_default_policy::merge_buffer_bytes;
+    }
+}();
 
-        epilogue: // merge what is left from either cursor1 or cursor2
+// Constants of a tuning policy, and run lengths derived from them, shared by the sorting
+// engines
+template <timsort_policy Policy>
+struct policy_constants {
+    static constexpr std::ptrdiff_t MIN_MERGE = Policy::min_merge;
+    static constexpr int MIN_GALLOP = Policy::min_gallop;
+    static constexpr int GALLOP_PENALTY = Policy::gallop_penalty;
+    static constexpr int MIN_GALLOP_FLOOR = Policy::min_gallop_floor;
+    static constexpr std::size_t MERGE_BUFFER_BYTES = merge_buffer_bytes<Policy>;
 
-        minGallop_ = (std::min)(minGallop, 1);
+    static_assert(MIN_MERGE >= 2, "min_merge must be at least 2");
+    static_assert(MIN_GALLOP >= 1, "min_gallop must be at least 1");
+    static_assert(MIN_GALLOP_FLOOR >= 1, "min_gallop_floor must be at least 1");
 
-        if (len1 == 1) {
-            GFX_TIMSORT_ASSERT(len2 > 0);
-            std::ranges::move(cursor2, cursor2 + len2, dest);
-            *(dest + len2) = std::ranges::iter_move(cursor1);
+    template <typename Diff>
+    static constexpr Diff minRunLength(Diff n) {
+        GFX_TIMSORT_ASSERT(n >= 0);
+
+        if constexpr (requires { Policy::min_run_length(n); }) {
+            Diff const minRun = Policy::min_run_length(n);
+            GFX_TIMSORT_ASSERT(minRun >= 1);
+            return minRun;
         } else {
-            GFX_TIMSORT_ASSERT(len1 != 0 && "Comparison function violates its general contract");
-            GFX_TIMSORT_ASSERT(len2 == 0);
-            GFX_TIMSORT_ASSERT(len1 > 1);
-            std::ranges::move(cursor1, cursor1 + len1, dest);
+            Diff r = 0;
+            while (n >= 2 * MIN_MERGE) {
+                r |= (n & 1);
+                n >>= 1;
+            }
+            return n + r;
+        }
+    }
+};
+
+// Element moves of TimSort and temporary storage of its merges: elements are moved within
+// the range, to the temporary storage, and from the temporary storage back to the range.
+// Sorts reordering other ranges along with the sorted one replace it to apply every move
+// to all the ranges.
+template <typename Iterator, std::size_t InlineBytes>
+class element_moves {
+    using value_t = std::iter_value_t<Iterator>;
+    using diff_t = std::iter_difference_t<Iterator>;
+
+    merge_buffer<value_t, InlineBytes> tmp_;
+
+public:
+    constexpr std::size_t capacity() const {
+        return tmp_.capacity();
+    }
+
+    constexpr std::size_t heapBytes() const {
+        return tmp_.heapBytes();
+    }
+
+    constexpr void reserve(std::size_t const count) {
+        tmp_.reserve(count);
+    }
+
+    // Moves the len elements starting at first to the temporary storage
+    constexpr value_t* toTmp(Iterator const first, diff_t const len) {
+        return tmp_.assign(first, len);
+    }
+
+    constexpr void move(Iterator const from, Iterator const to) {
+        *to = std::ranges::iter_move(from);
+    }
+
+    constexpr void moveFromTmp(value_t* const from, Iterator const to) {
+        *to = std::ranges::iter_move(from);
+    }
+
+    constexpr void moveRange(Iterator const first, Iterator const last, Iterator const out) {
+        detail::moveRange(first, last, out);
+    }
+
+    constexpr void moveRangeBackward(Iterator const first, Iterator const last,
+                                     Iterator const outLast) {
+        detail::moveRangeBackward(first, last, outLast);
+    }
+
+    constexpr void moveRangeFromTmp(value_t* const first, value_t* const last,
+                                    Iterator const out) {
+        detail::moveRange(first, last, out);
+    }
+
+    constexpr void rotateLeft(Iterator const first, Iterator const last) {
+        auto tmp = std::ranges::iter_move(first);
+        *detail::moveRange(std::ranges::next(first), last, first) = std::move(tmp);
+    }
+
+    constexpr void rotateRight(Iterator const first, Iterator const last) {
+        auto const last_1 = std::ranges::prev(last);
+        auto tmp = std::ranges::iter_move(last_1);
+        detail::moveRangeBackward(first, last_1, last);
+        *first = std::move(tmp);
+    }
+
+    constexpr void reverse(Iterator const first, Iterator const last) {
+        std::ranges::reverse(first, last);
+    }
+};
+
+template <
+    typename RandomAccessIterator,
+    typename Stats = void,
+    timsort_policy Policy = timsort_traits<std::iter_value_t<RandomAccessIterator>>,
+    typename Moves = element_moves<RandomAccessIterator, merge_buffer_bytes<Policy>>
+>
+class TimSort : policy_constants<Policy> {
+    using iter_t = RandomAccessIterator;
+    using value_t = typename std::iterator_traits<iter_t>::value_type;
+    using diff_t = typename std::iterator_traits<iter_t>::difference_type;
+    using constants_t = policy_constants<Policy>;
+
+    using constants_t::MIN_MERGE;
+    using constants_t::MIN_GALLOP;
+    using constants_t::GALLOP_PENALTY;
+    using constants_t::MIN_GALLOP_FLOOR;
+    using constants_t::minRunLength;
+    static constexpr int MIN_GATHER = 64;
+    static constexpr diff_t MAX_TINY = 4;
+
+    template <typename, typename, timsort_policy, typename>
+    friend class TimSort;
+
+    // Non-contiguous iterators (std::deque, strided or transformed views...) pay
+    // for segmented or strided address arithmetic at every step of the merge and
+    // galloping loops: past MIN_GATHER elements it is cheaper to move everything
+    // to a contiguous buffer, to sort it there and to move it back
+    static constexpr bool canGather =
+        !std::contiguous_iterator<iter_t>
+        && std::is_lvalue_reference_v<std::iter_reference_t<iter_t>>
+        && std::same_as<std::remove_cvref_t<std::iter_reference_t<iter_t>>, value_t>
+        && std::same_as<Moves, element_moves<iter_t, merge_buffer_bytes<Policy>>>;
+
+    template <typename Compare, typename Projection>
+    static constexpr bool gatherable =
+        canGather && std::sortable<value_t*, Compare, Projection>;
+
+    // Contiguous buffer the ranges are gathered to and sorting object sorting them there,
+    // both reused by every range this object sorts
+    struct gather_workspace {
+        std::vector<value_t> buffer;
+        TimSort<value_t*, Stats, Policy> sorter;
+
+        constexpr explicit gather_workspace(stats_recorder<Stats> stats) : sorter(stats) {
         }
+    };
+
+    struct no_gather_workspace {
+        constexpr explicit no_gather_workspace(stats_recorder<Stats>) {
+        }
+    };
+
+    int minGallop_ = MIN_GALLOP;
+    Moves moves_; // element moves and temp storage for merges
+    run_stack<RandomAccessIterator> pending_;
+    [[no_unique_address]] stats_recorder<Stats> stats_;
+    [[no_unique_address]] std::conditional_t<
+        canGather, gather_workspace, no_gather_workspace
+    > gathered_;
+    iter_t lo_ = {}; // beginning of the range, to compute the offsets of events
+
+    template <typename Compare, typename Projection>
+    constexpr void binarySort(iter_t const lo, iter_t const hi, iter_t start,
+                              Compare comp, Projection proj) {
+        GFX_TIMSORT_ASSERT(lo <= start);
+        GFX_TIMSORT_ASSERT(start <= hi);
+        if (start == lo) {
+            ++start;
+        }
+        for (; start < hi; ++start) {
+            GFX_TIMSORT_ASSERT(lo <= start);
+            auto pos = std::ranges::upper_bound(lo, start, std::invoke(proj, *start), comp, proj);
+            rotateRight(pos, std::ranges::next(start));
+        }
+    }
+
+    template <typename Compare, typename Projection>
+    constexpr diff_t countRunAndMakeAscending(iter_t const lo, iter_t const hi,
+                                              Compare comp, Projection proj) {
+        GFX_TIMSORT_ASSERT(lo < hi);
+
+        auto runHi = std::ranges::next(lo);
+        if (runHi == hi) {
+            return 1;
+        }
+
+        if (std::invoke(comp, std::invoke(proj, *runHi), std::invoke(proj, *lo))) { // decreasing
+            do {
+                ++runHi;
+            } while (runHi < hi && std::invoke(comp,
+                                               std::invoke(proj, *runHi),
+                                               std::invoke(proj, *std::ranges::prev(runHi))));
+            moves_.reverse(lo, runHi);
+            stats_.addMoves(3 * ((runHi - lo) / 2));
+        } else { // non-decreasing
+            do {
+                ++runHi;
+            } while (runHi < hi && !std::invoke(comp,
+                                                std::invoke(proj, *runHi),
+                                                std::invoke(proj, *std::ranges::prev(runHi))));
+        }
+
+        return runHi - lo;
+    }
+
+    constexpr void pushRun(iter_t const runBase, diff_t const runLen) {
+        pending_.emplace_back(runBase, runLen);
+        stats_.updatePendingBytes(pending_.size() * sizeof(run<iter_t>));
+    }
+
+    template <typename Compare, typename Projection>
+    constexpr void mergeCollapse(Compare comp, Projection proj) {
+        pending_.collapse([&](std::size_t const i) { mergeAt(i, comp, proj); });
+    }
+
+    template <typename Compare, typename Projection>
+    constexpr void mergeForceCollapse(Compare comp, Projection proj) {
+        pending_.forceCollapse([&](std::size_t const i) { mergeAt(i, comp, proj); });
+    }
+
+    template <typename Compare, typename Projection>
+    constexpr void mergeAt(std::size_t const i, Compare comp, Projection proj) {
+        auto const stackSize = static_cast<diff_t>(pending_.size());
+        auto const [run1, run2] = pending_.joinAt(i);
+
+        auto mergeStart = stats_.startMerge();
+        mergeConsecutiveRuns(run1.base, run1.len, run2.base, run2.len,
+                             std::move(comp), std::move(proj));
+        stats_.finishMerge(mergeStart, run1.base - lo_, run1.len, run2.len, stackSize);
+    }
+
+    template <typename Compare, typename Projection>
+    constexpr void mergeConsecutiveRuns(iter_t base1, diff_t len1, iter_t base2, diff_t len2,
+                                        Compare comp, Projection proj) {
+        GFX_TIMSORT_ASSERT(len1 > 0);
+        GFX_TIMSORT_ASSERT(len2 > 0);
+        GFX_TIMSORT_ASSERT(base1 + len1 == base2);
+
+        auto k = gallopRight(std::invoke(proj, *base2), base1, len1, 0, comp, proj);
+        GFX_TIMSORT_ASSERT(k >= 0);
+
+        base1 += k;
+        len1 -= k;
+
+        if (len1 == 0) {
+            return;
+        }
+
+        len2 = gallopLeft(std::invoke(proj, base1[len1 - 1]), base2, len2, len2 - 1, comp, proj);
+        GFX_TIMSORT_ASSERT(len2 >= 0);
+        if (len2 == 0) {
+            return;
+        }
+
+        if (len1 <= len2) {
+            mergeLo(base1, len1, base2, len2, comp, proj);
+        } else {
+            mergeHi(base1, len1, base2, len2, comp, proj);
+        }
+    }
+
+    constexpr void rotateLeft(iter_t first, iter_t last) {
+        stats_.addMoves((last - first) + 1);
+        moves_.rotateLeft(first, last);
+    }
+
+    constexpr void rotateRight(iter_t first, iter_t last) {
+        stats_.addMoves((last - first) + 1);
+        moves_.rotateRight(first, last);
     }
 
     template <typename Compare, typename Projection>
-    void mergeHi(iter_t const base1, diff_t len1, iter_t const base2, diff_t len2,
-                 Compare comp, Projection proj) {
+    constexpr void mergeLo(iter_t const base1, diff_t len1, iter_t const base2, diff_t len2,
+                           Compare comp, Projection proj) {
         GFX_TIMSORT_ASSERT(len1 > 0);
         GFX_TIMSORT_ASSERT(len2 > 0);
         GFX_TIMSORT_ASSERT(base1 + len1 == base2);
@@ -491,15 +1130,16 @@ class TimSort {
             return rotateRight(base1, base2 + len2);
         }
 
-        move_to_tmp(base2, len2);
-
-        auto cursor1 = base1 + len1;
-        auto cursor2 = tmp_.begin() + (len2 - 1);
-        auto dest = base2 + (len2 - 1);
+        stats_.addMergeLo();
+        stats_.addMoves(len1 + len2);
+        auto cursor1 = move_to_tmp(base1, len1);
+        auto cursor2 = base2;
+        auto dest = base1;
 
-        *dest = std::ranges::iter_move(--cursor1);
-        --dest;
-        --len1;
+        moves_.move(cursor2, dest);
+        ++cursor2;
+        ++dest;
+        --len2;
 
         int minGallop(minGallop_);
 
@@ -508,39 +1148,175 @@ class TimSort {
             diff_t count1 = 0;
             diff_t count2 = 0;
 
-            // The next loop is a hot path of the algorithm, so we decrement
-            // eagerly the cursor so that it always points directly to the value
-            // to compare, but we have to implement some trickier logic to make
-            // sure that it points to the next value again by the end of said loop
-            --cursor1;
-
             do {
-                GFX_TIMSORT_ASSERT(len1 > 0);
-                GFX_TIMSORT_ASSERT(len2 > 1);
+                GFX_TIMSORT_ASSERT(len1 > 1);
+                GFX_TIMSORT_ASSERT(len2 > 0);
 
                 if (std::invoke(comp, std::invoke(proj, *cursor2), std::invoke(proj, *cursor1))) {
-                    *dest = std::ranges::iter_move(cursor1);
-                    --dest;
-                    ++count1;
-                    count2 = 0;
-                    if (--len1 == 0) {
-                        goto epilogue;
-                    }
-                    --cursor1;
-                } else {
-                    *dest = std::ranges::iter_move(cursor2);
-                    --cursor2;
-                    --dest;
+                    moves_.move(cursor2, dest);
+                    ++cursor2;
+                    ++dest;
                     ++count2;
                     count1 = 0;
-                    if (--len2 == 1) {
-                        ++cursor1; // See comment before the loop
-                        goto epilogue;
+                    if (--len2 == 0) {
+                        break;
+                    }
+                } else {
+                    moves_.moveFromTmp(cursor1, dest);
+                    ++cursor1;
+                    ++dest;
+                    ++count1;
+                    count2 = 0;
+                    if (--len1 == 1) {
+                        break;
+                    }
+                }
+            } while ((count1 | count2) < minGallop);
+            if (len1 <= 1 || len2 == 0) {
+                break; // one of the runs is exhausted
+            }
+
+            auto gallopStart = stats_.startGalloping();
+            auto gallopDest = dest;
+            do {
+                GFX_TIMSORT_ASSERT(len1 > 1);
+                GFX_TIMSORT_ASSERT(len2 > 0);
+
+                count1 = gallopRight(std::invoke(proj, *cursor2), cursor1, len1, 0, comp, proj);
+                if (count1 != 0) {
+                    moves_.moveRangeFromTmp(cursor1, cursor1 + count1, dest);
+                    dest += count1;
+                    cursor1 += count1;
+                    len1 -= count1;
+
+                    if (len1 <= 1) {
+                        break;
+                    }
+                }
+                moves_.move(cursor2, dest);
+                ++cursor2;
+                ++dest;
+                if (--len2 == 0) {
+                    break;
+                }
+
+                count2 = gallopLeft(std::invoke(proj, *cursor1), cursor2, len2, 0, comp, proj);
+                if (count2 != 0) {
+                    moves_.moveRange(cursor2, cursor2 + count2, dest);
+                    dest += count2;
+                    cursor2 += count2;
+                    len2 -= count2;
+                    if (len2 == 0) {
+                        break;
+                    }
+                }
+                moves_.moveFromTmp(cursor1, dest);
+                ++cursor1;
+                ++dest;
+                if (--len1 == 1) {
+                    break;
+                }
+
+                --minGallop;
+            } while ((count1 >= MIN_GALLOP) | (count2 >= MIN_GALLOP));
+            stats_.finishGalloping(gallopStart, gallopDest - lo_, dest - gallopDest,
+                                   pending_.size());
+            if (len1 <= 1 || len2 == 0) {
+                break; // one of the runs is exhausted
+            }
+
+            if (minGallop < 0) {
+                minGallop = 0;
+            }
+            minGallop += GALLOP_PENALTY;
+        } // end of "outer" loop
+
+        // Merge what is left from either cursor1 or cursor2
+
+        minGallop_ = (std::max)(minGallop, MIN_GALLOP_FLOOR);
+
+        if (len1 == 1) {
+            GFX_TIMSORT_ASSERT(len2 > 0);
+            moves_.moveRange(cursor2, cursor2 + len2, dest);
+            moves_.moveFromTmp(cursor1, dest + len2);
+        } else {
+            GFX_TIMSORT_ASSERT(len1 != 0 && "Comparison function violates its general contract");
+            GFX_TIMSORT_ASSERT(len2 == 0);
+            GFX_TIMSORT_ASSERT(len1 > 1);
+            moves_.moveRangeFromTmp(cursor1, cursor1 + len1, dest);
+        }
+    }
+
+    template <typename Compare, typename Projection>
+    constexpr void mergeHi(iter_t const base1, diff_t len1, iter_t const base2, diff_t len2,
+                           Compare comp, Projection proj) {
+        GFX_TIMSORT_ASSERT(len1 > 0);
+        GFX_TIMSORT_ASSERT(len2 > 0);
+        GFX_TIMSORT_ASSERT(base1 + len1 == base2);
+
+        if (len1 == 1) {
+            return rotateLeft(base1, base2 + len2);
+        }
+        if (len2 == 1) {
+            return rotateRight(base1, base2 + len2);
+        }
+
+        stats_.addMergeHi();
+        stats_.addMoves(len1 + len2);
+        auto const tmp = move_to_tmp(base2, len2);
+
+        auto cursor1 = base1 + len1;
+        auto cursor2 = tmp + (len2 - 1);
+        auto dest = base2 + (len2 - 1);
+
+        moves_.move(--cursor1, dest);
+        --dest;
+        --len1;
+
+        int minGallop(minGallop_);
+
+        // outer:
+        while (true) {
+            diff_t count1 = 0;
+            diff_t count2 = 0;
+
+            // The next loop is a hot path of the algorithm, so we decrement
+            // eagerly the cursor so that it always points directly to the value
+            // to compare, but we have to implement some trickier logic to make
+            // sure that it points to the next value again by the end of said loop
+            --cursor1;
+
+            do {
+                GFX_TIMSORT_ASSERT(len1 > 0);
+                GFX_TIMSORT_ASSERT(len2 > 1);
+
+                if (std::invoke(comp, std::invoke(proj, *cursor2), std::invoke(proj, *cursor1))) {
+                    moves_.move(cursor1, dest);
+                    --dest;
+                    ++count1;
+                    count2 = 0;
+                    if (--len1 == 0) {
+                        break;
+                    }
+                    --cursor1;
+                } else {
+                    moves_.moveFromTmp(cursor2, dest);
+                    --cursor2;
+                    --dest;
+                    ++count2;
+                    count1 = 0;
+                    if (--len2 == 1) {
+                        break;
                     }
                 }
             } while ((count1 | count2) < minGallop);
             ++cursor1; // See comment before the loop
+            if (len1 == 0 || len2 <= 1) {
+                break; // one of the runs is exhausted
+            }
 
+            auto gallopStart = stats_.startGalloping();
+            auto gallopDest = dest;
             do {
                 GFX_TIMSORT_ASSERT(len1 > 0);
                 GFX_TIMSORT_ASSERT(len2 > 1);
@@ -551,212 +1327,3224 @@ class TimSort {
                     dest -= count1;
                     cursor1 -= count1;
                     len1 -= count1;
-                    std::ranges::move_backward(cursor1, cursor1 + count1, dest + (1 + count1));
+                    moves_.moveRangeBackward(cursor1, cursor1 + count1, dest + (1 + count1));
 
                     if (len1 == 0) {
-                        goto epilogue;
+                        break;
                     }
                 }
-                *dest = std::ranges::iter_move(cursor2);
+                moves_.moveFromTmp(cursor2, dest);
                 --cursor2;
                 --dest;
                 if (--len2 == 1) {
-                    goto epilogue;
+                    break;
                 }
 
                 count2 = len2 - gallopLeft(std::invoke(proj, *std::ranges::prev(cursor1)),
-                                           tmp_.begin(), len2, len2 - 1, comp, proj);
+                                           tmp, len2, len2 - 1, comp, proj);
                 if (count2 != 0) {
                     dest -= count2;
                     cursor2 -= count2;
                     len2 -= count2;
-                    std::ranges::move(std::ranges::next(cursor2),
-                                      cursor2 + (1 + count2),
-                                      std::ranges::next(dest));
+                    moves_.moveRangeFromTmp(std::ranges::next(cursor2), cursor2 + (1 + count2),
+                                            std::ranges::next(dest));
                     if (len2 <= 1) {
-                        goto epilogue;
+                        break;
                     }
                 }
-                *dest = std::ranges::iter_move(--cursor1);
+                moves_.move(--cursor1, dest);
                 --dest;
                 if (--len1 == 0) {
-                    goto epilogue;
+                    break;
                 }
 
                 --minGallop;
             } while ((count1 >= MIN_GALLOP) | (count2 >= MIN_GALLOP));
+            stats_.finishGalloping(gallopStart, (dest + 1) - lo_, gallopDest - dest,
+                                   pending_.size());
+            if (len1 == 0 || len2 <= 1) {
+                break; // one of the runs is exhausted
+            }
 
             if (minGallop < 0) {
                 minGallop = 0;
             }
-            minGallop += 2;
+            minGallop += GALLOP_PENALTY;
         } // end of "outer" loop
 
-        epilogue: // merge what is left from either cursor1 or cursor2
+        // Merge what is left from either cursor1 or cursor2
+
+        minGallop_ = (std::max)(minGallop, MIN_GALLOP_FLOOR);
+
+        if (len2 == 1) {
+            GFX_TIMSORT_ASSERT(len1 > 0);
+            dest -= len1;
+            moves_.moveRangeBackward(cursor1 - len1, cursor1, dest + (1 + len1));
+            moves_.moveFromTmp(cursor2, dest);
+        } else {
+            GFX_TIMSORT_ASSERT(len2 != 0 && "Comparison function violates its general contract");
+            GFX_TIMSORT_ASSERT(len1 == 0);
+            GFX_TIMSORT_ASSERT(len2 > 1);
+            moves_.moveRangeFromTmp(tmp, tmp + len2, dest - (len2 - 1));
+        }
+    }
+
+    constexpr value_t* move_to_tmp(iter_t const begin, diff_t len) {
+        auto res = moves_.toTmp(begin, len);
+        stats_.addMoves(len);
+        stats_.updateTmpBytes(moves_.heapBytes());
+        return res;
+    }
+
+    // Sorts [lo, hi) in the gather buffer, which only grows when the range doesn't fit
+    template <typename Compare, typename Projection>
+    constexpr void gatherSortScatter(iter_t const lo, iter_t const hi,
+                                     Compare comp, Projection proj) {
+        auto& buffer = gathered_.buffer;
+        buffer.assign(std::make_move_iterator(lo), std::make_move_iterator(hi));
+        stats_.addMoves(2 * (hi - lo));
+        stats_.updateTmpBytes(buffer.capacity() * sizeof(value_t));
+        gathered_.sorter.sortRange(buffer.data(), buffer.data() + buffer.size(),
+                                   std::move(comp), std::move(proj));
+        minGallop_ = gathered_.sorter.minGallop_;
+        std::ranges::move(buffer, lo);
+
+        GFX_TIMSORT_LOG("size: " << (hi - lo));
+    }
+
+    // Sorts [lo, hi) with this sorting object, which may have sorted other ranges before
+    template <typename Compare, typename Projection>
+    constexpr void sortRange(iter_t const lo, iter_t const hi, Compare comp, Projection proj) {
+        auto const nRemaining = hi - lo;
+        if constexpr (gatherable<Compare, Projection>) {
+            if (nRemaining >= MIN_GATHER) {
+                return gatherSortScatter(lo, hi, std::move(comp), std::move(proj));
+            }
+        }
+
+        // The state of the previous sort must not leak into this one
+        minGallop_ = MIN_GALLOP;
+        if (nRemaining < MIN_MERGE) {
+            sortSmall(lo, hi, std::move(comp), std::move(proj));
+        } else {
+            sortRuns(lo, hi, minRunLength(nRemaining), std::move(comp), std::move(proj));
+            pending_.clear();
+        }
+    }
+
+public:
+
+    template <typename... MovesArgs>
+    constexpr explicit TimSort(stats_recorder<Stats> stats = {}, MovesArgs const&... movesArgs) :
+        moves_(movesArgs...), stats_(stats), gathered_(stats) {
+    }
+
+    template <typename Compare, typename Projection>
+    static constexpr void merge(iter_t const lo, iter_t const mid, iter_t const hi,
+                                Compare comp, Projection proj,
+                                stats_recorder<Stats> stats = {}) {
+        GFX_TIMSORT_ASSERT(lo <= mid);
+        GFX_TIMSORT_ASSERT(mid <= hi);
+
+        if (lo == mid || mid == hi) {
+            return; // nothing to do
+        }
+
+        TimSort ts(stats);
+        ts.lo_ = lo;
+        auto mergeStart = stats.startMerge();
+        ts.mergeConsecutiveRuns(lo, mid - lo, mid, hi - mid, std::move(comp), std::move(proj));
+        stats.finishMerge(mergeStart, 0, mid - lo, hi - mid, 0);
+        stats.setMinGallop(ts.minGallop_);
+
+        GFX_TIMSORT_LOG("1st size: " << (mid - lo) << "; 2nd size: " << (hi - mid)
+                                     << "; tmp_.capacity(): " << ts.moves_.capacity());
+    }
+
+    // The arguments following the statistics are passed to the constructor of the moves
+    template <typename Compare, typename Projection, typename... MovesArgs>
+    static constexpr void sort(iter_t const lo, iter_t const hi, Compare comp, Projection proj,
+                               stats_recorder<Stats> stats = {},
+                               MovesArgs const&... movesArgs) {
+        GFX_TIMSORT_ASSERT(lo <= hi);
+
+        auto nRemaining = hi - lo;
+        if (nRemaining < 2) {
+            return; // nothing to do
+        }
+
+        TimSort ts(stats, movesArgs...);
+        ts.sortRange(lo, hi, std::move(comp), std::move(proj));
+        stats.setMinGallop(ts.minGallop_);
+    }
+
+    // Sorts a range made of consecutive sorted runs whose boundaries are known: the runs are
+    // pushed as they are, only the merges are left to do
+    template <typename Boundaries, typename Compare, typename Projection>
+    static constexpr void sortGivenRuns(iter_t const lo, iter_t const hi, Boundaries&& boundaries,
+                                        Compare comp, Projection proj) {
+        TimSort ts;
+        ts.lo_ = lo;
+        diff_t runStart = 0;
+        auto pushRunUpTo = [&](diff_t const runEnd) {
+            GFX_TIMSORT_ASSERT(runStart <= runEnd);
+            GFX_TIMSORT_ASSERT(runEnd <= hi - lo);
+            if (runEnd > runStart) {
+                GFX_TIMSORT_AUDIT(std::ranges::is_sorted(lo + runStart, lo + runEnd, comp, proj)
+                                  && "Precondition");
+                ts.pushRun(lo + runStart, runEnd - runStart);
+                ts.mergeCollapse(comp, proj);
+                runStart = runEnd;
+            }
+        };
+        for (auto const boundary : boundaries) {
+            pushRunUpTo(static_cast<diff_t>(boundary));
+        }
+        pushRunUpTo(hi - lo);
+        ts.mergeForceCollapse(comp, proj);
+    }
+
+    // Finds the runs of [lo, hi) and extends the short ones to minRun elements like sort does,
+    // but hands them to onRun(base, len) instead of merging them
+    template <typename Compare, typename Projection, typename OnRun>
+    static void findRuns(iter_t const lo, iter_t const hi, diff_t const minRun,
+                         Compare comp, Projection proj, OnRun onRun) {
+        GFX_TIMSORT_ASSERT(lo < hi);
+
+        TimSort ts;
+        ts.lo_ = lo;
+        ts.forEachRun(lo, hi, minRun, std::move(comp), std::move(proj), std::move(onRun));
+    }
+
+    // Sorts a range whose elements before mid are already sorted: they are pushed as a single
+    // run, and only the rest of the range is scanned for runs
+    template <typename Compare, typename Projection>
+    static constexpr void sortTail(iter_t const lo, iter_t const mid, iter_t const hi,
+                                   Compare comp, Projection proj) {
+        GFX_TIMSORT_ASSERT(lo <= mid);
+        GFX_TIMSORT_ASSERT(mid <= hi);
+
+        if (mid == hi) {
+            return; // nothing to do
+        }
+
+        TimSort ts;
+        ts.lo_ = lo;
+        if (lo != mid) {
+            ts.pushRun(lo, mid - lo);
+        }
+        ts.scanRuns(mid, hi, minRunLength(hi - mid), comp, proj);
+        ts.mergeForceCollapse(comp, proj);
+    }
+
+    // Sorts the ranges of a batch one after the other with the same sorting object, so that
+    // the temporary storage is reused by all the sorts: it is allocated once, with room for
+    // the biggest merge of the batch and for the biggest range gathered to a contiguous
+    // buffer. The ranges are sorted by size class, which keeps the code of each kind of sort
+    // hot instead of alternating between them: the tiny ones with a sorting network first,
+    // then the ones too small to be merged, then the others
+    template <typename RangeIterator, typename Compare, typename Projection>
+    static constexpr void sortBatch(RangeIterator const first, RangeIterator const last,
+                                    Compare comp, Projection proj) {
+        TimSort ts;
+        ts.sortRanges(first, last, std::move(comp), std::move(proj));
+    }
+
+    // Sorts a chunk of a batch with one of the sorting objects of the batch, which the
+    // workspaces hand out to the tasks sorting the chunks in parallel
+    template <typename RangeIterator, typename Compare, typename Projection,
+              typename Workspaces>
+    static void sortBatch(RangeIterator const first, RangeIterator const last,
+                          Compare comp, Projection proj, Workspaces& workspaces) {
+        workspaces.use([&](std::unique_ptr<TimSort>& ts) {
+            if (ts == nullptr) {
+                ts = std::make_unique<TimSort>();
+            }
+            ts->sortRanges(first, last, comp, proj);
+        });
+    }
+
+    // Sorts a range whose size is known at compile time: the choice of the algorithm
+    // and the minimum run length are both computed at compile time
+    template <diff_t N, typename Compare, typename Projection>
+    static constexpr void sortFixed(iter_t const lo, Compare comp, Projection proj) {
+        if constexpr (N < 2) {
+            return; // nothing to do
+        } else if constexpr (N < MIN_MERGE) {
+            TimSort ts;
+            ts.sortSmall(lo, lo + N, std::move(comp), std::move(proj));
+        } else {
+            constexpr diff_t minRun = minRunLength(N);
+            TimSort ts;
+            ts.sortRuns(lo, lo + N, minRun, std::move(comp), std::move(proj));
+        }
+    }
+
+private:
+
+    // Sorts the ranges of a batch with this sorting object, see sortBatch
+    template <typename RangeIterator, typename Compare, typename Projection>
+    constexpr void sortRanges(RangeIterator const first, RangeIterator const last,
+                              Compare comp, Projection proj) {
+        auto forEachRange = [first, last](auto fn) {
+            for (auto it = first; it != last; ++it) {
+                auto&& range = *it;
+                auto const lo = std::ranges::begin(range);
+                fn(lo, std::ranges::next(lo, std::ranges::end(range)));
+            }
+        };
+
+        diff_t maxLen = 0;
+        diff_t maxGathered = 0;
+        forEachRange([&](iter_t const lo, iter_t const hi) {
+            if (hi - lo <= MAX_TINY) {
+                sortTiny(lo, hi - lo, comp, proj);
+            } else if (gatherable<Compare, Projection>
+                       && hi - lo >= MIN_GATHER && hi - lo >= MIN_MERGE) {
+                maxGathered = (std::max)(maxGathered, hi - lo);
+            } else {
+                maxLen = (std::max)(maxLen, hi - lo);
+            }
+        });
+        forEachRange([&](iter_t const lo, iter_t const hi) {
+            if (hi - lo > MAX_TINY && hi - lo < MIN_MERGE) {
+                sortSmall(lo, hi, comp, proj);
+            }
+        });
+
+        // Merges move at most the smaller of two runs to the temporary storage
+        if (maxLen >= MIN_MERGE) {
+            moves_.reserve(static_cast<std::size_t>(maxLen / 2));
+        }
+        if constexpr (gatherable<Compare, Projection>) {
+            if (maxGathered != 0) {
+                gathered_.buffer.reserve(static_cast<std::size_t>(maxGathered));
+                gathered_.sorter.moves_.reserve(static_cast<std::size_t>(maxGathered / 2));
+            }
+        }
+        forEachRange([&](iter_t const lo, iter_t const hi) {
+            if (hi - lo >= MIN_MERGE) {
+                sortRange(lo, hi, comp, proj);
+            }
+        });
+    }
+
+    // Sorts up to MAX_TINY elements with a network of compare-exchanges of neighbours,
+    // which never lets equal elements cross each other
+    template <typename Compare, typename Projection>
+    static constexpr void sortTiny(iter_t const lo, diff_t const n, Compare comp, Projection proj) {
+        GFX_TIMSORT_ASSERT(n <= MAX_TINY);
+        for (diff_t pass = n - 1; pass > 0; --pass) {
+            for (auto it = lo; it != lo + pass; ++it) {
+                if (std::invoke(comp, std::invoke(proj, *std::ranges::next(it)),
+                                std::invoke(proj, *it))) {
+                    std::ranges::iter_swap(it, std::ranges::next(it));
+                }
+            }
+        }
+    }
+
+    template <typename Compare, typename Projection>
+    constexpr void sortSmall(iter_t const lo, iter_t const hi, Compare comp, Projection proj) {
+        auto runStart = stats_.startRun();
+        auto initRunLen = countRunAndMakeAscending(lo, hi, comp, proj);
+        GFX_TIMSORT_LOG("initRunLen: " << initRunLen);
+        stats_.finishRun(runStart, 0, initRunLen, 0);
+
+        if (initRunLen < hi - lo) {
+            auto sortStart = stats_.startBinarySort();
+            binarySort(lo, hi, lo + initRunLen, comp, proj);
+            stats_.finishBinarySort(sortStart, 0, hi - lo, 0);
+        }
+    }
+
+    template <typename Compare, typename Projection>
+    constexpr void sortRuns(iter_t const lo, iter_t const hi, diff_t const minRun,
+                            Compare comp, Projection proj) {
+        lo_ = lo;
+        scanRuns(lo, hi, minRun, comp, proj);
+        mergeForceCollapse(comp, proj);
+        GFX_TIMSORT_ASSERT(pending_.size() == 1);
+
+        GFX_TIMSORT_LOG("size: " << (hi - lo) << " tmp_.capacity(): " << moves_.capacity()
+                                 << " pending_.size(): " << pending_.size());
+    }
+
+    // Finds the runs of [lo, hi), extends the short ones to minRun elements and pushes them
+    template <typename Compare, typename Projection>
+    constexpr void scanRuns(iter_t const lo, iter_t const hi, diff_t const minRun,
+                            Compare comp, Projection proj) {
+        forEachRun(lo, hi, minRun, comp, proj, [&](iter_t const runBase, diff_t const runLen) {
+            pushRun(runBase, runLen);
+            mergeCollapse(comp, proj);
+        });
+    }
+
+    // Finds the runs of [lo, hi), extends the short ones to minRun elements and calls
+    // onRun(base, len) for each of them in order
+    template <typename Compare, typename Projection, typename OnRun>
+    constexpr void forEachRun(iter_t const lo, iter_t const hi, diff_t const minRun,
+                              Compare comp, Projection proj, OnRun onRun) {
+        auto nRemaining = hi - lo;
+        auto cur = lo;
+        do {
+            auto runStart = stats_.startRun();
+            auto runLen = countRunAndMakeAscending(cur, hi, comp, proj);
+            stats_.finishRun(runStart, cur - lo_, runLen, pending_.size());
+
+            if (runLen < minRun) {
+                auto force = (std::min)(nRemaining, minRun);
+                auto sortStart = stats_.startBinarySort();
+                binarySort(cur, cur + force, cur + runLen, comp, proj);
+                stats_.finishBinarySort(sortStart, cur - lo_, force, pending_.size());
+                runLen = force;
+            }
+
+            onRun(cur, runLen);
+
+            cur += runLen;
+            nRemaining -= runLen;
+        } while (nRemaining != 0);
+
+        GFX_TIMSORT_ASSERT(cur == hi);
+    }
+};
+
+// ---------------------------------------
+// TimSort over strings with LCP caching
+// ---------------------------------------
+
+template <typename T>
+inline constexpr bool is_basic_string = false;
+
+template <typename Char, typename Traits, typename Allocator>
+inline constexpr bool is_basic_string<std::basic_string<Char, Traits, Allocator>> = true;
+
+template <typename T>
+inline constexpr bool is_basic_string_view = false;
+
+template <typename Char, typename Traits>
+inline constexpr bool is_basic_string_view<std::basic_string_view<Char, Traits>> = true;
+
+// Ranges whose projected elements are strings compared with the default comparison;
+// the projection has to return references or string views so that the characters
+// outlive the comparisons
+template <typename Iter, typename Projection>
+using projected_key_t = std::remove_cvref_t<std::indirect_result_t<Projection&, Iter>>;
+
+template <typename Iter, typename Compare, typename Projection>
+concept lcp_sortable =
+    ((is_basic_string<projected_key_t<Iter, Projection>>
+      && std::is_reference_v<std::indirect_result_t<Projection&, Iter>>)
+     || is_basic_string_view<projected_key_t<Iter, Projection>>)
+    && (std::same_as<Compare, std::ranges::less> || std::same_as<Compare, std::less<>>
+        || std::same_as<Compare, std::less<projected_key_t<Iter, Projection>>>);
+
+// TimSort keeping, for every element of a pending run, the length of the longest
+// common prefix (LCP) it shares with the previous element of the run. The runs are
+// merged like in LCP mergesort: the element output last is no greater than the heads
+// of both runs, so when the heads share prefixes of different lengths with it, the
+// one sharing the longest prefix is the smallest without looking at a character;
+// otherwise the heads are compared from their first possibly differing character.
+// Galloping searches for the end of a winning streak with the same rule, and binary
+// insertion sort skips the prefix shared with both bounds of its search range.
+// Merges always move the first run to the temporary buffer, which is needed for the
+// LCPs of the merged run to be computed front to back.
+template <typename RandomAccessIterator, typename Projection, typename Policy>
+class LcpTimSort : policy_constants<Policy> {
+    using iter_t = RandomAccessIterator;
+    using value_t = typename std::iterator_traits<iter_t>::value_type;
+    using diff_t = typename std::iterator_traits<iter_t>::difference_type;
+    using key_t = projected_key_t<iter_t, Projection>;
+    using traits_t = typename key_t::traits_type;
+    using char_t = typename key_t::value_type;
+    using view_t = std::basic_string_view<char_t, traits_t>;
+    using constants_t = policy_constants<Policy>;
+
+    using constants_t::MIN_GALLOP;
+    using constants_t::GALLOP_PENALTY;
+    using constants_t::MIN_GALLOP_FLOOR;
+    using constants_t::MERGE_BUFFER_BYTES;
+    using constants_t::minRunLength;
+
+    // Result of a comparison starting after a prefix known to be shared
+    struct comparison {
+        std::size_t lcp;
+        int order; // negative, zero or positive
+    };
+
+    // Result of galloping over a run for a key
+    struct gallop_result {
+        diff_t count;          // number of leading elements ordered before the key
+        std::size_t lcpLast;   // LCP of the key and of the last of these elements
+        std::size_t lcpNext;   // LCP of the key and of the element following them
+    };
+
+    Projection proj_;
+    iter_t lo_;
+    int minGallop_ = MIN_GALLOP;
+    std::vector<std::size_t> lcp_;    // lcp_[i]: LCP of lo_[i - 1] and lo_[i] in a run
+    merge_buffer<value_t, MERGE_BUFFER_BYTES> tmp_;
+    std::vector<std::size_t> tmpLcp_; // LCPs of the elements of tmp_
+    run_stack<RandomAccessIterator> pending_;
+
+    constexpr LcpTimSort(iter_t const lo, diff_t const len, Projection proj) :
+        proj_(std::move(proj)), lo_(lo), lcp_(static_cast<std::size_t>(len)) {
+    }
+
+    template <typename It>
+    constexpr view_t key(It it) const {
+        return view_t(std::invoke(proj_, *it));
+    }
+
+    // Compares two strings known to share their first `from` characters
+    static constexpr comparison compareFrom(view_t const lhs, view_t const rhs,
+                                            std::size_t from) {
+        auto const size = (std::min)(lhs.size(), rhs.size());
+        GFX_TIMSORT_ASSERT(from <= size);
+        if constexpr (std::same_as<traits_t, std::char_traits<char_t>>
+                      && (std::endian::native == std::endian::little
+                          || std::endian::native == std::endian::big)) {
+            // The standard traits compare characters like their bytes: look for the
+            // first differing byte a word at a time, the last word overlapping the
+            // characters already known to be equal
+            constexpr std::size_t step = sizeof(std::uint64_t) / sizeof(char_t);
+            constexpr std::size_t block = 4 * step;
+            if (!std::is_constant_evaluated() && size >= step) {
+                // Long common prefixes are skipped a few words at a time
+                for (; from + block <= size; from += block) {
+                    std::uint64_t lwords[4], rwords[4];
+                    std::memcpy(lwords, lhs.data() + from, sizeof(lwords));
+                    std::memcpy(rwords, rhs.data() + from, sizeof(rwords));
+                    if (((lwords[0] ^ rwords[0]) | (lwords[1] ^ rwords[1])
+                         | (lwords[2] ^ rwords[2]) | (lwords[3] ^ rwords[3])) != 0) {
+                        break;
+                    }
+                }
+                while (from < size) {
+                    from = (std::min)(from, size - step);
+                    std::uint64_t lword, rword;
+                    std::memcpy(&lword, lhs.data() + from, sizeof(lword));
+                    std::memcpy(&rword, rhs.data() + from, sizeof(rword));
+                    if (auto const diff = lword ^ rword; diff != 0) {
+                        auto const bits = std::endian::native == std::endian::little
+                                        ? std::countr_zero(diff) : std::countl_zero(diff);
+                        from += static_cast<std::size_t>(bits) / (8 * sizeof(char_t));
+                        return { from, traits_t::lt(lhs[from], rhs[from]) ? -1 : 1 };
+                    }
+                    from += step;
+                }
+            }
+        }
+        while (from < size && traits_t::eq(lhs[from], rhs[from])) {
+            ++from;
+        }
+        if (from < size) {
+            return { from, traits_t::lt(lhs[from], rhs[from]) ? -1 : 1 };
+        }
+        return { from, lhs.size() < rhs.size() ? -1 : (lhs.size() > rhs.size() ? 1 : 0) };
+    }
+
+    constexpr std::size_t& lcpAt(iter_t const it) {
+        return lcp_[static_cast<std::size_t>(it - lo_)];
+    }
+
+    // Finds the run starting at lo and makes it ascending, recording its LCPs
+    constexpr diff_t countRunAndMakeAscending(iter_t const lo, iter_t const hi) {
+        GFX_TIMSORT_ASSERT(lo < hi);
+
+        auto runHi = std::ranges::next(lo);
+        if (runHi == hi) {
+            return 1;
+        }
+
+        auto cmp = compareFrom(key(lo), key(runHi), 0);
+        lcpAt(runHi) = cmp.lcp;
+        if (cmp.order > 0) { // strictly decreasing
+            while (++runHi < hi) {
+                cmp = compareFrom(key(runHi - 1), key(runHi), 0);
+                if (cmp.order <= 0) {
+                    break;
+                }
+                lcpAt(runHi) = cmp.lcp;
+            }
+            // The LCPs of adjacent elements don't depend on their order
+            std::ranges::reverse(lo, runHi);
+            std::reverse(&lcpAt(lo) + 1, &lcpAt(lo) + (runHi - lo));
+        } else { // non-decreasing
+            while (++runHi < hi) {
+                cmp = compareFrom(key(runHi - 1), key(runHi), 0);
+                if (cmp.order > 0) {
+                    break;
+                }
+                lcpAt(runHi) = cmp.lcp;
+            }
+        }
+
+        return runHi - lo;
+    }
+
+    // Binary insertion sort keeping track of the LCPs of the key with both bounds
+    // of the search range: every element in between shares at least the smallest
+    // of both prefixes with the key
+    constexpr void binarySort(iter_t const lo, iter_t const hi, iter_t start) {
+        GFX_TIMSORT_ASSERT(lo < start);
+        GFX_TIMSORT_ASSERT(start <= hi);
+        for (; start < hi; ++start) {
+            auto const pivot = key(start);
+            auto left = lo;
+            auto right = start;
+            std::size_t lcpLeft = 0;  // LCP with the element before left
+            std::size_t lcpRight = 0; // LCP with the element at right
+            while (left < right) {
+                auto const mid = left + (right - left) / 2;
+                auto const cmp = compareFrom(pivot, key(mid), (std::min)(lcpLeft, lcpRight));
+                if (cmp.order < 0) {
+                    right = mid;
+                    lcpRight = cmp.lcp;
+                } else {
+                    left = mid + 1;
+                    lcpLeft = cmp.lcp;
+                }
+            }
+
+            // Insert the element and the LCPs with its new neighbours
+            auto lcps = &lcpAt(lo);
+            auto const pos = left - lo;
+            auto const end = start - lo;
+            std::copy_backward(lcps + pos, lcps + end, lcps + end + 1);
+            if (pos > 0) {
+                lcps[pos] = lcpLeft;
+            }
+            if (pos < end) {
+                lcps[pos + 1] = lcpRight;
+            }
+            rotateRight(left, std::ranges::next(start));
+        }
+    }
+
+    constexpr void rotateRight(iter_t first, iter_t last) {
+        auto last_1 = std::ranges::prev(last);
+        auto tmp = std::ranges::iter_move(last_1);
+        moveRangeBackward(first, last_1, last);
+        *first = std::move(tmp);
+    }
+
+    // Counts the leading elements of a run ordered before the key: the elements not
+    // greater than the key, or the elements less than it when Strict is true. The last
+    // element output is no greater than the key and than the elements of the run, and
+    // shares the first lcpKey characters with the key and the first lcpFirst ones with
+    // the first element. lcps[i] is the LCP of the elements i - 1 and i of the run.
+    template <bool Strict, typename It>
+    constexpr gallop_result gallop(view_t const pivot, std::size_t const lcpKey,
+                                   It const first, std::size_t const* const lcps,
+                                   diff_t const len, std::size_t const lcpFirst) {
+        GFX_TIMSORT_ASSERT(len > 0);
+
+        // Last element known to be ordered before the key
+        diff_t last = -1;
+        gallop_result res = { 0, lcpKey, 0 };
+
+        // Records whether the element at pos is ordered before the key, and their LCP
+        auto record = [&](diff_t const pos, bool const before, std::size_t const lcp) {
+            if (before) {
+                last = pos;
+                res.lcpLast = lcp;
+            } else {
+                res.lcpNext = lcp;
+            }
+            return before;
+        };
+        // Orders the element at pos and the key, whose first lcp characters are the same
+        auto isBefore = [&](diff_t const pos, std::size_t const lcp) {
+            auto const cmp = compareFrom(key(first + pos), pivot, lcp);
+            return record(pos, Strict ? cmp.order < 0 : cmp.order <= 0, cmp.lcp);
+        };
+
+        // Exponential search, up to the last element of the run: the LCP of the probed
+        // element with the last element output is the minimum of the LCPs of the elements
+        // up to it, carried forward as the probe moves, and only the probes sharing as
+        // many characters with it as the key does need their characters compared
+        diff_t after = len;
+        std::size_t shared = lcpFirst;
+        diff_t scanned = 0;
+        for (diff_t pos = 0, step = 1; ; pos = (std::min)(pos + step, len - 1), step *= 2) {
+            while (scanned < pos) {
+                shared = (std::min)(shared, lcps[++scanned]);
+            }
+            bool const before = shared == lcpKey
+                ? isBefore(pos, lcpKey)
+                : record(pos, shared > lcpKey, (std::min)(shared, lcpKey));
+            if (!before) {
+                after = pos;
+                break;
+            }
+            if (pos == len - 1) {
+                break;
+            }
+        }
+
+        // Binary search between the last element known to be ordered before the key and
+        // the first one known to be ordered after it: the elements between them share at
+        // least the shorter of the prefixes both share with the key
+        diff_t left = last + 1;
+        while (left < after) {
+            auto const mid = left + (after - left) / 2;
+            if (isBefore(mid, (std::min)(res.lcpLast, res.lcpNext))) {
+                left = mid + 1;
+            } else {
+                after = mid;
+            }
+        }
+
+        res.count = last + 1;
+        return res;
+    }
+
+    constexpr void mergeAt(std::size_t const i) {
+        auto const [run1, run2] = pending_.joinAt(i);
+        mergeRuns(run1.base, run1.len, run2.base, run2.len);
+    }
+
+    constexpr void mergeRuns(iter_t base1, diff_t len1, iter_t const base2, diff_t len2) {
+        GFX_TIMSORT_ASSERT(len1 > 0);
+        GFX_TIMSORT_ASSERT(len2 > 0);
+        GFX_TIMSORT_ASSERT(base1 + len1 == base2);
+
+        // Elements of the first run already in place, nothing is known about their
+        // prefixes yet so the search starts with an empty string as last output
+        auto const trim = gallop<false>(key(base2), 0, base1, &lcpAt(base1), len1, 0);
+        if (trim.count == len1) {
+            lcpAt(base2) = trim.lcpLast;
+            return;
+        }
+
+        // LCPs of the heads of both runs with the last element output
+        std::size_t lcp1 = trim.count > 0 ? lcpAt(base1 + trim.count) : 0;
+        std::size_t lcp2 = trim.count > 0 ? trim.lcpLast : 0;
+        base1 += trim.count;
+        len1 -= trim.count;
+
+        auto cursor1 = tmp_.assign(base1, len1);
+        tmpLcp_.assign(&lcpAt(base1), &lcpAt(base1) + len1);
+        auto const lcps1 = tmpLcp_.data();
+        auto cursor2 = base2;
+        auto dest = base1;
+
+        // Output functions, the LCP of the element output with the previous output
+        // is the one of the head of its run
+        auto output1 = [&] {
+            lcpAt(dest) = lcp1;
+            *dest = std::ranges::iter_move(cursor1);
+            ++dest;
+            ++cursor1;
+            --len1;
+        };
+        auto output2 = [&] {
+            lcpAt(dest) = lcp2;
+            *dest = std::ranges::iter_move(cursor2);
+            ++dest;
+            ++cursor2;
+            --len2;
+        };
+
+        int minGallop = minGallop_;
+        while (len1 > 0 && len2 > 0) {
+            diff_t count1 = 0;
+            diff_t count2 = 0;
+
+            // One element at a time until one of the runs wins consistently
+            do {
+                if (lcp1 > lcp2) {
+                    output1();
+                    ++count1;
+                    count2 = 0;
+                    if (len1 > 0) {
+                        lcp1 = lcps1[cursor1 - tmp_.data()];
+                    }
+                } else if (lcp1 < lcp2) {
+                    output2();
+                    ++count2;
+                    count1 = 0;
+                    if (len2 > 0) {
+                        lcp2 = lcpAt(cursor2);
+                    }
+                } else {
+                    auto const cmp = compareFrom(key(cursor1), key(cursor2), lcp1);
+                    if (cmp.order <= 0) {
+                        output1();
+                        ++count1;
+                        count2 = 0;
+                        lcp2 = cmp.lcp;
+                        if (len1 > 0) {
+                            lcp1 = lcps1[cursor1 - tmp_.data()];
+                        }
+                    } else {
+                        output2();
+                        ++count2;
+                        count1 = 0;
+                        lcp1 = cmp.lcp;
+                        if (len2 > 0) {
+                            lcp2 = lcpAt(cursor2);
+                        }
+                    }
+                }
+            } while (len1 > 0 && len2 > 0 && (count1 | count2) < minGallop);
+            if (len1 == 0 || len2 == 0) {
+                break;
+            }
+
+            // Galloping mode
+            do {
+                auto const gallop1 = gallop<false>(key(cursor2), lcp2, cursor1,
+                                                   lcps1 + (cursor1 - tmp_.data()), len1, lcp1);
+                count1 = gallop1.count;
+                if (count1 != 0) {
+                    lcpAt(dest) = lcp1;
+                    auto const offset = cursor1 - tmp_.data();
+                    std::copy(lcps1 + offset + 1, lcps1 + offset + count1, &lcpAt(dest) + 1);
+                    dest = moveRange(cursor1, cursor1 + count1, dest);
+                    cursor1 += count1;
+                    len1 -= count1;
+                    lcp2 = gallop1.lcpLast;
+                    if (len1 == 0) {
+                        break;
+                    }
+                }
+                // The head of the second run is less than the head of the first one
+                lcp1 = gallop1.lcpNext;
+                output2();
+                if (len2 == 0) {
+                    break;
+                }
+                lcp2 = lcpAt(cursor2);
+
+                auto const gallop2 = gallop<true>(key(cursor1), lcp1, cursor2,
+                                                  &lcpAt(cursor2), len2, lcp2);
+                count2 = gallop2.count;
+                if (count2 != 0) {
+                    lcpAt(dest) = lcp2;
+                    std::copy(&lcpAt(cursor2) + 1, &lcpAt(cursor2) + count2, &lcpAt(dest) + 1);
+                    dest = moveRange(cursor2, cursor2 + count2, dest);
+                    cursor2 += count2;
+                    len2 -= count2;
+                    lcp1 = gallop2.lcpLast;
+                    if (len2 == 0) {
+                        break;
+                    }
+                }
+                // The head of the first run is not greater than the head of the second one
+                lcp2 = gallop2.lcpNext;
+                output1();
+                if (len1 == 0) {
+                    break;
+                }
+                lcp1 = lcps1[cursor1 - tmp_.data()];
+
+                --minGallop;
+            } while ((count1 >= MIN_GALLOP) | (count2 >= MIN_GALLOP));
+            if (len1 == 0 || len2 == 0) {
+                break;
+            }
+
+            if (minGallop < 0) {
+                minGallop = 0;
+            }
+            minGallop += GALLOP_PENALTY;
+        }
+
+        minGallop_ = (std::max)(minGallop, MIN_GALLOP_FLOOR);
+
+        if (len1 == 0) {
+            // The rest of the second run is already in place
+            if (len2 > 0) {
+                lcpAt(cursor2) = lcp2;
+            }
+        } else {
+            GFX_TIMSORT_ASSERT(len2 == 0);
+            auto const offset = cursor1 - tmp_.data();
+            lcpAt(dest) = lcp1;
+            std::copy(lcps1 + offset + 1, lcps1 + offset + len1, &lcpAt(dest) + 1);
+            moveRange(cursor1, cursor1 + len1, dest);
+        }
+    }
+
+public:
+    // Below that size the LCPs aren't worth allocating
+    static constexpr diff_t MIN_SIZE = 256;
+
+    // Characters are compared a word at a time or faster, skipping shorter prefixes
+    // doesn't make up for the bookkeeping
+    static constexpr std::size_t MIN_PREFIX_BYTES = 64;
+    static constexpr diff_t PREFIX_SAMPLES = 16;
+
+    // Whether the range is large enough, and whether pairs of elements sampled from
+    // it share long enough prefixes on average, for the LCPs to pay off
+    static constexpr bool worthwhile(iter_t const lo, iter_t const hi,
+                                     Projection& proj) {
+        auto const len = hi - lo;
+        if (len < MIN_SIZE) {
+            return false;
+        }
+        auto const step = len / PREFIX_SAMPLES;
+        std::size_t total = 0;
+        for (diff_t i = 0; i < PREFIX_SAMPLES; ++i) {
+            auto const first = lo + i * step;
+            total += compareFrom(view_t(std::invoke(proj, *first)),
+                                 view_t(std::invoke(proj, *(first + step / 2))), 0).lcp;
+        }
+        return total * sizeof(char_t) >= MIN_PREFIX_BYTES * PREFIX_SAMPLES;
+    }
+
+    static constexpr void sort(iter_t const lo, iter_t const hi, Projection proj) {
+        GFX_TIMSORT_ASSERT(hi - lo >= MIN_SIZE);
+
+        auto nRemaining = hi - lo;
+        LcpTimSort ts(lo, nRemaining, std::move(proj));
+        auto const minRun = minRunLength(nRemaining);
+        auto cur = lo;
+        do {
+            auto runLen = ts.countRunAndMakeAscending(cur, hi);
+
+            if (runLen < minRun) {
+                auto const force = (std::min)(nRemaining, minRun);
+                ts.binarySort(cur, cur + force, cur + runLen);
+                runLen = force;
+            }
+
+            ts.pending_.emplace_back(cur, runLen);
+            ts.pending_.collapse([&](std::size_t const i) { ts.mergeAt(i); });
+
+            cur += runLen;
+            nRemaining -= runLen;
+        } while (nRemaining != 0);
+
+        GFX_TIMSORT_ASSERT(cur == hi);
+        ts.pending_.forceCollapse([&](std::size_t const i) { ts.mergeAt(i); });
+        GFX_TIMSORT_ASSERT(ts.pending_.size() == 1);
+
+        GFX_TIMSORT_LOG("size: " << (hi - lo) << " tmp_.capacity(): " << ts.tmp_.capacity());
+    }
+};
+
+// ---------------------------------------
+// Node-based TimSort for linked lists
+// ---------------------------------------
+
+template <typename List>
+concept spliceable_list = requires (List& list, std::ranges::iterator_t<List> it) {
+    list.splice(it, list, it, it);
+};
+
+// Relinking operations over a list providing std::list-like splice operations
+template <typename List>
+struct list_links {
+    using position = std::ranges::iterator_t<List>;
+
+    List* list;
+
+    static position next(position pos) {
+        return std::ranges::next(pos);
+    }
+
+    static decltype(auto) deref(position pos) {
+        return *pos;
+    }
+
+    // Moves the nodes [first, tail] right before pos
+    void splice(position pos, position first, position tail) const {
+        list->splice(pos, *list, first, std::ranges::next(tail));
+    }
+};
+
+// Relinking operations over raw doubly linked nodes described by a hook
+template <typename Node, typename Hook>
+struct node_links {
+    using position = Node*;
+
+    [[no_unique_address]] Hook hook;
+
+    position next(position pos) const {
+        return hook.next(pos);
+    }
+
+    static Node& deref(position pos) {
+        return *pos;
+    }
+
+    // Moves the nodes [first, tail] right before pos
+    void splice(position pos, position first, position tail) const {
+        Node* before = hook.prev(first);
+        Node* after = hook.next(tail);
+        if (before != nullptr) {
+            hook.set_next(before, after);
+        }
+        if (after != nullptr) {
+            hook.set_prev(after, before);
+        }
+
+        Node* pos_prev = hook.prev(pos);
+        hook.set_prev(first, pos_prev);
+        if (pos_prev != nullptr) {
+            hook.set_next(pos_prev, first);
+        }
+        hook.set_next(tail, pos);
+        hook.set_prev(pos, tail);
+    }
+};
+
+// TimSort variant that reorders the nodes of a linked list by relinking them:
+// it never moves the elements themselves and doesn't need a temporary buffer.
+// Positions are only ever moved forward, and the end of the sequences is
+// tracked with their lengths, so the node following the last one is never
+// accessed.
+template <typename Links, typename Policy>
+class ListTimSort : policy_constants<Policy> {
+    using pos_t = typename Links::position;
+    using diff_t = std::ptrdiff_t;
+    using constants_t = policy_constants<Policy>;
+
+    using constants_t::MIN_MERGE;
+    using constants_t::MIN_GALLOP;
+    using constants_t::GALLOP_PENALTY;
+    using constants_t::MIN_GALLOP_FLOOR;
+    using constants_t::minRunLength;
+
+    Links links_;
+    int minGallop_ = MIN_GALLOP;
+    run_stack<pos_t> pending_;
+
+    explicit ListTimSort(Links links) : links_(std::move(links)) {
+    }
+
+    pos_t advance(pos_t pos, diff_t n) const {
+        for (; n > 0; --n) {
+            pos = links_.next(pos);
+        }
+        return pos;
+    }
+
+    // Binary search for the partition point of the len elements starting at pos:
+    // pos ends on the first element not satisfying pred, and tail on the last one
+    // satisfying it, if any
+    template <typename Pred>
+    diff_t partitionPoint(pos_t& pos, pos_t& tail, diff_t len, Pred pred) const {
+        diff_t count = 0;
+        while (len > 0) {
+            diff_t const half = len / 2;
+            pos_t mid = advance(pos, half);
+            if (pred(Links::deref(mid))) {
+                tail = mid;
+                pos = links_.next(mid);
+                count += half + 1;
+                len -= half + 1;
+            } else {
+                len = half;
+            }
+        }
+        return count;
+    }
+
+    // Same as partitionPoint, but performs an exponential search first, which
+    // is cheaper in comparisons when the partition point is close to pos
+    template <typename Pred>
+    diff_t gallop(pos_t& pos, pos_t& tail, diff_t len, Pred pred) const {
+        if (len == 0 || !pred(Links::deref(pos))) {
+            return 0;
+        }
+
+        tail = pos;
+        diff_t count = 1;
+        diff_t step = 1;
+        while (count - 1 + step < len) {
+            pos_t probe = advance(tail, step);
+            if (!pred(Links::deref(probe))) {
+                pos = links_.next(tail);
+                return count + partitionPoint(pos, tail, step - 1, pred);
+            }
+            tail = probe;
+            count += step;
+            step <<= 1;
+        }
+        pos = links_.next(tail);
+        return count + partitionPoint(pos, tail, len - count, pred);
+    }
+
+    // Extends the sorted run starting at base to force nodes, and returns the
+    // node following it
+    template <typename Compare, typename Projection>
+    pos_t binarySort(pos_t& base, diff_t runLen, diff_t const force, pos_t next,
+                     Compare comp, Projection proj) {
+        GFX_TIMSORT_ASSERT(runLen > 0);
+        GFX_TIMSORT_ASSERT(runLen <= force);
+
+        for (; runLen < force; ++runLen) {
+            pos_t const cur = next;
+            next = links_.next(cur);
+
+            auto&& key = std::invoke(proj, Links::deref(cur));
+            pos_t pos = base;
+            pos_t tail = base;
+            auto const k = partitionPoint(pos, tail, runLen, [&](auto&& x) {
+                return !std::invoke(comp, key, std::invoke(proj, x));
+            });
+            if (k != runLen) {
+                links_.splice(pos, cur, cur);
+                if (k == 0) {
+                    base = cur;
+                }
+            }
+        }
+        return next;
+    }
+
+    template <typename Compare, typename Projection>
+    diff_t countRunAndMakeAscending(pos_t& base, pos_t& next, diff_t const len,
+                                    Compare comp, Projection proj) {
+        GFX_TIMSORT_ASSERT(len > 0);
+
+        diff_t runLen = 1;
+        pos_t cur = links_.next(base);
+        if (len == 1) {
+            next = cur;
+            return runLen;
+        }
+
+        if (std::invoke(comp, std::invoke(proj, Links::deref(cur)),
+                              std::invoke(proj, Links::deref(base)))) { // decreasing
+            // Reverse the run by moving each new node in front of it
+            do {
+                pos_t const after = links_.next(cur);
+                links_.splice(base, cur, cur);
+                base = cur;
+                cur = after;
+                ++runLen;
+            } while (runLen < len && std::invoke(comp,
+                                                 std::invoke(proj, Links::deref(cur)),
+                                                 std::invoke(proj, Links::deref(base))));
+        } else { // non-decreasing
+            pos_t last = base;
+            do {
+                last = cur;
+                cur = links_.next(cur);
+                ++runLen;
+            } while (runLen < len && !std::invoke(comp,
+                                                  std::invoke(proj, Links::deref(cur)),
+                                                  std::invoke(proj, Links::deref(last))));
+        }
+
+        next = cur;
+        return runLen;
+    }
+
+    template <typename Compare, typename Projection>
+    void mergeCollapse(Compare comp, Projection proj) {
+        pending_.collapse([&](std::size_t const i) { mergeAt(i, comp, proj); });
+    }
+
+    template <typename Compare, typename Projection>
+    void mergeForceCollapse(Compare comp, Projection proj) {
+        pending_.forceCollapse([&](std::size_t const i) { mergeAt(i, comp, proj); });
+    }
+
+    template <typename Compare, typename Projection>
+    void mergeAt(std::size_t const i, Compare comp, Projection proj) {
+        auto const [run1, run2] = pending_.joinAt(i);
+        // The first node of the merged run may come from the second run
+        pending_[i].base = mergeConsecutiveRuns(run1.base, run1.len, run2.base, run2.len,
+                                                std::move(comp), std::move(proj));
+    }
+
+    // Merges two consecutive runs in place and returns the first node of the
+    // merged run. Nodes from the second run are spliced in front of the first
+    // node of the first run they compare less than: the rest of the second run
+    // never needs to be walked once the first one is exhausted.
+    template <typename Compare, typename Projection>
+    pos_t mergeConsecutiveRuns(pos_t const base1, diff_t len1, pos_t const base2, diff_t len2,
+                               Compare comp, Projection proj) {
+        GFX_TIMSORT_ASSERT(len1 > 0);
+        GFX_TIMSORT_ASSERT(len2 > 0);
+
+        pos_t cursor1 = base1;
+        pos_t cursor2 = base2;
+        pos_t tail = base1;
+
+        auto const lessEqualKey2 = [&](auto&& x) {
+            return !std::invoke(comp, std::invoke(proj, Links::deref(cursor2)),
+                                      std::invoke(proj, x));
+        };
+        auto const lessThanKey1 = [&](auto&& x) {
+            return std::invoke(comp, std::invoke(proj, x),
+                                     std::invoke(proj, Links::deref(cursor1)));
+        };
+
+        auto const k = gallop(cursor1, tail, len1, lessEqualKey2);
+        len1 -= k;
+        if (len1 == 0) {
+            return base1;
+        }
+
+        // The first node of the second run now goes right before cursor1
+        pos_t const newBase = (k == 0) ? base2 : base1;
+        int minGallop(minGallop_);
+
+        // outer:
+        while (true) {
+            diff_t count1 = 0;
+            diff_t count2 = 0;
+
+            do {
+                GFX_TIMSORT_ASSERT(len1 > 0);
+                GFX_TIMSORT_ASSERT(len2 > 0);
+
+                if (std::invoke(comp, std::invoke(proj, Links::deref(cursor2)),
+                                      std::invoke(proj, Links::deref(cursor1)))) {
+                    pos_t const next2 = links_.next(cursor2);
+                    links_.splice(cursor1, cursor2, cursor2);
+                    cursor2 = next2;
+                    ++count2;
+                    count1 = 0;
+                    if (--len2 == 0) {
+                        break;
+                    }
+                } else {
+                    cursor1 = links_.next(cursor1);
+                    ++count1;
+                    count2 = 0;
+                    if (--len1 == 0) {
+                        break;
+                    }
+                }
+            } while ((count1 | count2) < minGallop);
+            if (len1 == 0 || len2 == 0) {
+                break; // one of the runs is exhausted
+            }
+
+            do {
+                GFX_TIMSORT_ASSERT(len1 > 0);
+                GFX_TIMSORT_ASSERT(len2 > 0);
+
+                count1 = gallop(cursor1, tail, len1, lessEqualKey2);
+                len1 -= count1;
+                if (len1 == 0) {
+                    break;
+                }
+
+                pos_t const first2 = cursor2;
+                count2 = gallop(cursor2, tail, len2, lessThanKey1);
+                GFX_TIMSORT_ASSERT(count2 > 0);
+                links_.splice(cursor1, first2, tail);
+                len2 -= count2;
+                if (len2 == 0) {
+                    break;
+                }
+
+                --minGallop;
+            } while ((count1 >= MIN_GALLOP) | (count2 >= MIN_GALLOP));
+            if (len1 == 0 || len2 == 0) {
+                break; // one of the runs is exhausted
+            }
+
+            if (minGallop < 0) {
+                minGallop = 0;
+            }
+            minGallop += GALLOP_PENALTY;
+        } // end of "outer" loop
+
+        // Whatever is left of the second run is already in place
+
+        minGallop_ = (std::max)(minGallop, MIN_GALLOP_FLOOR);
+        return newBase;
+    }
+
+public:
+
+    // Sorts the n nodes starting at lo and returns the new first node
+    template <typename Compare, typename Projection>
+    static pos_t sort(Links links, pos_t const lo, diff_t const n,
+                      Compare comp, Projection proj) {
+        GFX_TIMSORT_ASSERT(n >= 0);
+
+        if (n < 2) {
+            return lo; // nothing to do
+        }
+
+        ListTimSort ts(std::move(links));
+        auto const minRun = (n < MIN_MERGE) ? n : minRunLength(n);
+        auto nRemaining = n;
+        auto cur = lo;
+        do {
+            auto runBase = cur;
+            auto runLen = ts.countRunAndMakeAscending(runBase, cur, nRemaining, comp, proj);
+
+            if (runLen < minRun) {
+                auto force = (std::min)(nRemaining, minRun);
+                cur = ts.binarySort(runBase, runLen, force, cur, comp, proj);
+                runLen = force;
+            }
+
+            ts.pending_.emplace_back(runBase, runLen);
+            ts.mergeCollapse(comp, proj);
+
+            nRemaining -= runLen;
+        } while (nRemaining != 0);
+
+        ts.mergeForceCollapse(comp, proj);
+        GFX_TIMSORT_ASSERT(ts.pending_.size() == 1);
+
+        GFX_TIMSORT_LOG("size: " << n << " pending_.size(): " << ts.pending_.size());
+        return ts.pending_[0].base;
+    }
+};
+
+// ---------------------------------------
+// Abbreviated keys
+// ---------------------------------------
+
+// Abbreviation of an element and index of the element in the sorted range
+template <typename Diff>
+struct abbreviated_entry {
+    std::uint64_t key;
+    Diff index;
+};
+
+// ---------------------------------------
+// Permutations
+// ---------------------------------------
+
+// Moves the element at index perm[i] to index i for every i in [0, size), following the
+// cycles of the permutation so that every element is moved exactly once
+template <typename Iter, typename PermIter>
+void applyPermutation(Iter const first, std::iter_difference_t<Iter> const size,
+                      PermIter const perm) {
+    using diff_t = std::iter_difference_t<Iter>;
+
+    std::vector<bool> placed(static_cast<std::size_t>(size));
+    for (diff_t start = 0; start < size; ++start) {
+        if (placed[start]) {
+            continue;
+        }
+        placed[start] = true;
+
+        diff_t current = start;
+        diff_t source = perm[start];
+        if (source == start) {
+            continue;
+        }
+
+        auto tmp = std::ranges::iter_move(first + start);
+        do {
+            first[current] = std::ranges::iter_move(first + source);
+            current = source;
+            placed[current] = true;
+            source = perm[current];
+        } while (source != start);
+        first[current] = std::move(tmp);
+    }
+}
+
+// ---------------------------------------
+// Floating-point total order
+// ---------------------------------------
+
+template <typename T>
+concept iec559_binary = std::floating_point<T> && std::numeric_limits<T>::is_iec559
+                     && (sizeof(T) == sizeof(std::uint32_t) || sizeof(T) == sizeof(std::uint64_t));
+
+template <typename T>
+using total_order_key_t =
+    std::conditional_t<sizeof(T) == sizeof(std::uint32_t), std::uint32_t, std::uint64_t>;
+
+// Maps a floating-point value to an unsigned integer, the integers being ordered like the
+// values in the IEEE 754 totalOrder predicate: -NaN < -inf < ... < -0 < +0 < ... < +inf < +NaN
+template <iec559_binary T>
+constexpr total_order_key_t<T> totalOrderKey(T const value) {
+    using key_t = total_order_key_t<T>;
+    constexpr key_t sign = key_t(1) << (8 * sizeof(key_t) - 1);
+    auto const bits = std::bit_cast<key_t>(value);
+    // Negative values are ordered backwards, before the positive ones
+    return (bits & sign) ? key_t(~bits) : key_t(bits | sign);
+}
+
+template <iec559_binary T>
+constexpr T fromTotalOrderKey(total_order_key_t<T> const key) {
+    using key_t = total_order_key_t<T>;
+    constexpr key_t sign = key_t(1) << (8 * sizeof(key_t) - 1);
+    return std::bit_cast<T>((key & sign) ? key_t(key ^ sign) : key_t(~key));
+}
+
+// Below that size the keys aren't worth allocating
+inline constexpr std::ptrdiff_t MIN_TOTAL_ORDER_KEYS = 256;
+
+// Sorts floating-point values in total order by sorting their keys instead: the keys are
+// cheaper to compare, and since equal keys are identical values, they are restored exactly
+template <typename Policy, typename Iter>
+void sortTotalOrderKeys(Iter const first, Iter const last) {
+    using value_t = std::iter_value_t<Iter>;
+    using key_t = total_order_key_t<value_t>;
+
+    std::vector<key_t> keys;
+    keys.reserve(static_cast<std::size_t>(last - first));
+    for (auto it = first; it != last; ++it) {
+        keys.push_back(totalOrderKey(static_cast<value_t>(*it)));
+    }
+    TimSort<typename std::vector<key_t>::iterator, void, Policy>::sort(
+        keys.begin(), keys.end(), std::ranges::less{}, std::identity{});
+    auto it = first;
+    for (auto key : keys) {
+        *it = fromTotalOrderKey<value_t>(key);
+        ++it;
+    }
+}
+
+// Maps a floating-point value to an unsigned integer ordered like the values for operator<,
+// with the NaNs after +inf; -0 and +0 get the same key, and so do all the NaNs
+template <iec559_binary T>
+constexpr total_order_key_t<T> nanLastKey(T const value) {
+    using key_t = total_order_key_t<T>;
+    if (value != value) {
+        return std::numeric_limits<key_t>::max();
+    }
+    return totalOrderKey(value == T(0) ? T(0) : value);
+}
+
+// Sorts elements whose projections are floating-point values in the order of nan_last_less
+// by sorting their keys instead: equivalent values have equal keys and are kept in order by
+// the stable sort of the keys. Plain values travel with their keys, other elements are
+// reordered afterwards with the indices travelling with the keys
+template <typename Policy, typename Iter, typename Projection>
+void sortNanLastKeys(Iter const first, Iter const last, Projection proj) {
+    using value_t = std::iter_value_t<Iter>;
+    using key_t = total_order_key_t<projected_key_t<Iter, Projection>>;
+    using diff_t = std::iter_difference_t<Iter>;
+    constexpr bool keep_values = std::same_as<Projection, std::identity>
+                              && std::same_as<value_t, projected_key_t<Iter, Projection>>;
+    using entry_t = std::pair<key_t, std::conditional_t<keep_values, value_t, diff_t>>;
+
+    std::vector<entry_t> entries;
+    entries.reserve(static_cast<std::size_t>(last - first));
+    for (diff_t i = 0; i < last - first; ++i) {
+        auto const key = nanLastKey(std::invoke(proj, first[i]));
+        if constexpr (keep_values) {
+            entries.emplace_back(key, first[i]);
+        } else {
+            entries.emplace_back(key, i);
+        }
+    }
+    TimSort<typename std::vector<entry_t>::iterator, void, Policy>::sort(
+        entries.begin(), entries.end(), std::ranges::less{}, &entry_t::first);
+
+    if constexpr (keep_values) {
+        auto it = first;
+        for (auto const& entry : entries) {
+            *it = entry.second;
+            ++it;
+        }
+    } else {
+        auto indices = std::views::transform(entries, &entry_t::second);
+        applyPermutation(first, last - first, indices.begin());
+    }
+}
+
+// ---------------------------------------
+// Galloping walk over two sorted ranges
+// ---------------------------------------
+
+// Walks two sorted ranges in lockstep the way mergeLo does: elements are compared
+// one-by-one until one of the ranges keeps winning, at which point the walk
+// switches to galloping, with the same minGallop adaptation and the galloping
+// constants of the policy. The callbacks are given the chunks of elements only
+// found in the first or second range, and consume equivalent elements from both
+// ranges. The walk stops as soon as one of the ranges is exhausted.
+template <
+    typename Policy,
+    typename Iter1, typename Iter2, typename Compare, typename Proj1, typename Proj2,
+    typename OnlyFirst, typename OnlySecond, typename Common
+>
+void gallopWalk(Iter1& first1, Iter1 const last1, Iter2& first2, Iter2 const last2,
+                Compare comp, Proj1 proj1, Proj2 proj2,
+                OnlyFirst onlyFirst, OnlySecond onlySecond, Common common) {
+    constexpr int MIN_GALLOP = policy_constants<Policy>::MIN_GALLOP;
+    constexpr int GALLOP_PENALTY = policy_constants<Policy>::GALLOP_PENALTY;
+
+    if (first1 == last1 || first2 == last2) {
+        return;
+    }
+
+    int minGallop = MIN_GALLOP;
+
+    // outer:
+    while (true) {
+        std::iter_difference_t<Iter1> count1 = 0;
+        std::iter_difference_t<Iter2> count2 = 0;
+
+        do {
+            if (std::invoke(comp, std::invoke(proj2, *first2), std::invoke(proj1, *first1))) {
+                onlySecond(first2, 1);
+                ++first2;
+                ++count2;
+                count1 = 0;
+                if (first2 == last2) {
+                    return;
+                }
+            } else if (std::invoke(comp, std::invoke(proj1, *first1),
+                                         std::invoke(proj2, *first2))) {
+                onlyFirst(first1, 1);
+                ++first1;
+                ++count1;
+                count2 = 0;
+                if (first1 == last1) {
+                    return;
+                }
+            } else {
+                common(first1, first2);
+                count1 = 0;
+                count2 = 0;
+                if (first1 == last1 || first2 == last2) {
+                    return;
+                }
+            }
+        } while ((count1 | count2) < minGallop);
+
+        do {
+            count1 = gallopLeft(std::invoke(proj2, *first2), first1, last1 - first1, 0,
+                                comp, proj1);
+            if (count1 != 0) {
+                onlyFirst(first1, count1);
+                first1 += count1;
+                if (first1 == last1) {
+                    return;
+                }
+            }
+
+            count2 = gallopLeft(std::invoke(proj1, *first1), first2, last2 - first2, 0,
+                                comp, proj2);
+            if (count2 != 0) {
+                onlySecond(first2, count2);
+                first2 += count2;
+                if (first2 == last2) {
+                    return;
+                }
+            }
+
+            if (!std::invoke(comp, std::invoke(proj1, *first1), std::invoke(proj2, *first2))) {
+                common(first1, first2);
+                if (first1 == last1 || first2 == last2) {
+                    return;
+                }
+            }
+
+            --minGallop;
+        } while ((count1 >= MIN_GALLOP) | (count2 >= MIN_GALLOP));
+
+        if (minGallop < 0) {
+            minGallop = 0;
+        }
+        minGallop += GALLOP_PENALTY;
+    } // end of "outer" loop
+}
+
+// ---------------------------------------
+// TimSort over keys and ranges of values
+// ---------------------------------------
+
+template <typename T>
+concept permutable_range =
+    std::ranges::random_access_range<T> && std::permutable<std::ranges::iterator_t<T>>;
+
+template <typename Keys, typename Compare, typename... Values>
+inline constexpr bool by_key_sortable =
+    std::sortable<std::ranges::iterator_t<Keys>, Compare> && (permutable_range<Values> && ...);
+
+// Whether the arguments following the keys are ranges of values, optionally followed by a
+// comparison function for the keys
+template <
+    typename Keys, typename Args,
+    typename Indices = std::make_index_sequence<std::tuple_size_v<Args> - 1>
+>
+inline constexpr bool by_key_arguments = false;
+
+template <typename Keys, typename... Args, std::size_t... I>
+inline constexpr bool by_key_arguments<Keys, std::tuple<Args...>, std::index_sequence<I...>> =
+    by_key_sortable<Keys, std::ranges::less, Args...>
+    || by_key_sortable<Keys, std::tuple_element_t<sizeof...(I), std::tuple<Args...>>,
+                       std::tuple_element_t<I, std::tuple<Args...>>...>;
+
+// Element moves of a TimSort over a range of keys, applying every move to the elements at
+// the same positions in the ranges of values. Every range has its own temporary storage, so
+// the merge and galloping loops read the keys from a buffer of keys only.
+template <std::size_t InlineBytes, typename KeyIterator, typename... ValueIterators>
+class by_key_moves {
+    using key_t = std::iter_value_t<KeyIterator>;
+    using diff_t = std::iter_difference_t<KeyIterator>;
+
+    KeyIterator keys_;
+    std::tuple<ValueIterators...> values_;
+    merge_buffer<key_t, InlineBytes> tmp_;
+    std::tuple<merge_buffer<std::iter_value_t<ValueIterators>, InlineBytes>...> tmpValues_;
+
+    // Calls fn with the beginning and the temporary storage of the keys, then of every
+    // range of values
+    template <typename Function>
+    constexpr void forEachRange(Function fn) {
+        fn(keys_, tmp_);
+        std::apply([&](auto&... bases) {
+            std::apply([&](auto&... buffers) {
+                (fn(bases, buffers), ...);
+            }, tmpValues_);
+        }, values_);
+    }
+
+public:
+    constexpr by_key_moves(KeyIterator const keys, ValueIterators const... values) :
+        keys_(keys), values_(values...) {
+    }
+
+    constexpr std::size_t capacity() const {
+        return tmp_.capacity();
+    }
+
+    constexpr std::size_t heapBytes() const {
+        return std::apply([&](auto const&... buffers) {
+            return (tmp_.heapBytes() + ... + buffers.heapBytes());
+        }, tmpValues_);
+    }
+
+    constexpr key_t* toTmp(KeyIterator const first, diff_t const len) {
+        forEachRange([offset = first - keys_, len](auto const base, auto& buffer) {
+            buffer.assign(base + offset, len);
+        });
+        return tmp_.data();
+    }
+
+    constexpr void move(KeyIterator const from, KeyIterator const to) {
+        forEachRange([from = from - keys_, to = to - keys_](auto const base, auto&) {
+            *(base + to) = std::ranges::iter_move(base + from);
+        });
+    }
+
+    constexpr void moveFromTmp(key_t* const from, KeyIterator const to) {
+        forEachRange([from = from - tmp_.data(), to = to - keys_](auto const base, auto& buffer) {
+            *(base + to) = std::ranges::iter_move(buffer.data() + from);
+        });
+    }
+
+    constexpr void moveRange(KeyIterator const first, KeyIterator const last,
+                             KeyIterator const out) {
+        forEachRange([first = first - keys_, last = last - keys_, out = out - keys_]
+                     (auto const base, auto&) {
+            detail::moveRange(base + first, base + last, base + out);
+        });
+    }
+
+    constexpr void moveRangeBackward(KeyIterator const first, KeyIterator const last,
+                                     KeyIterator const outLast) {
+        forEachRange([first = first - keys_, last = last - keys_, outLast = outLast - keys_]
+                     (auto const base, auto&) {
+            detail::moveRangeBackward(base + first, base + last, base + outLast);
+        });
+    }
+
+    constexpr void moveRangeFromTmp(key_t* const first, key_t* const last,
+                                    KeyIterator const out) {
+        forEachRange([first = first - tmp_.data(), last = last - tmp_.data(), out = out - keys_]
+                     (auto const base, auto& buffer) {
+            detail::moveRange(buffer.data() + first, buffer.data() + last, base + out);
+        });
+    }
+
+    constexpr void rotateLeft(KeyIterator const first, KeyIterator const last) {
+        forEachRange([first = first - keys_, last = last - keys_](auto const base, auto&) {
+            auto tmp = std::ranges::iter_move(base + first);
+            *detail::moveRange(base + (first + 1), base + last, base + first) = std::move(tmp);
+        });
+    }
+
+    constexpr void rotateRight(KeyIterator const first, KeyIterator const last) {
+        forEachRange([first = first - keys_, last = last - keys_](auto const base, auto&) {
+            auto tmp = std::ranges::iter_move(base + (last - 1));
+            detail::moveRangeBackward(base + first, base + (last - 1), base + last);
+            *(base + first) = std::move(tmp);
+        });
+    }
+
+    constexpr void reverse(KeyIterator const first, KeyIterator const last) {
+        forEachRange([first = first - keys_, last = last - keys_](auto const base, auto&) {
+            std::ranges::reverse(base + first, base + last);
+        });
+    }
+};
+
+// ---------------------------------------
+// Batches
+// ---------------------------------------
+
+// Audits of the algorithms of gfx/timsort_parallel.hpp, which can't see the configuration
+// macros undefined at the end of this header
+template <typename Check>
+void auditPrecondition([[maybe_unused]] Check check) {
+    GFX_TIMSORT_AUDIT(check() && "Precondition");
+}
+
+template <typename Check>
+void auditPostcondition([[maybe_unused]] Check check) {
+    GFX_TIMSORT_AUDIT(check() && "Postcondition");
+}
+
+// Iterator type of the ranges of a batch of ranges
+template <typename Ranges>
+using batch_iterator_t = std::ranges::iterator_t<std::ranges::range_reference_t<Ranges>>;
+
+// Segments of [first, last) delimited by consecutive offsets, the offsets of a range stored in
+// CSR layout, as a random-access range of subranges
+template <typename Iterator, typename Offsets>
+auto segments(Iterator const first, [[maybe_unused]] Iterator const last, Offsets &offsets) {
+    using diff_t = std::iter_difference_t<Iterator>;
+
+    auto const offsets_first = std::ranges::begin(offsets);
+    auto const count = std::ranges::distance(offsets);
+    GFX_TIMSORT_ASSERT(count == 0 || std::cmp_less_equal(0, offsets_first[0]));
+    GFX_TIMSORT_ASSERT(count == 0 || std::cmp_less_equal(offsets_first[count - 1], last - first));
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(offsets) && "Precondition");
+    return std::views::iota(decltype(count)(0), (std::max)(count - 1, decltype(count)(0)))
+         | std::views::transform([first, offsets_first](auto const i) {
+               return std::ranges::subrange(first + static_cast<diff_t>(offsets_first[i]),
+                                            first + static_cast<diff_t>(offsets_first[i + 1]));
+           });
+}
+
+} // namespace detail
+
+
+// ---------------------------------------
+// Floating-point orders
+// ---------------------------------------
+
+/**
+ * Orders floating-point values according to the IEEE 754 totalOrder predicate, which is a
+ * strict total order even with NaNs: -NaN < -inf < ... < -0 < +0 < ... < +inf < +NaN.
+ */
+struct total_order_less {
+    template <std::floating_point T>
+    constexpr auto operator()(T lhs, T rhs) const noexcept
+        -> bool
+    {
+        if constexpr (detail::iec559_binary<T>) {
+            return detail::totalOrderKey(lhs) < detail::totalOrderKey(rhs);
+        } else {
+            return std::strong_order(lhs, rhs) < 0;
+        }
+    }
+};
+
+/**
+ * Orders floating-point values with operator< and places NaNs after all the other values,
+ * which makes it a strict weak order even with NaNs; all NaNs are equivalent, and so are -0
+ * and +0.
+ */
+struct nan_last_less {
+    template <std::floating_point T>
+    constexpr auto operator()(T lhs, T rhs) const noexcept
+        -> bool
+    {
+        if (rhs != rhs) {
+            return lhs == lhs;
+        }
+        return lhs < rhs;
+    }
+};
+
+namespace detail {
+
+// Floating-point orders that gfx::timsort sorts with dedicated algorithms rather than
+// with plain comparisons
+template <typename Iter, typename Compare, typename Projection>
+concept float_order_sortable =
+    (std::same_as<Compare, total_order_less> && std::same_as<Projection, std::identity>
+     && iec559_binary<std::iter_value_t<Iter>>)
+    || (std::same_as<Compare, nan_last_less>
+        && iec559_binary<projected_key_t<Iter, Projection>>);
+
+} // namespace detail
+
+// ---------------------------------------
+// Public interface implementation
+// ---------------------------------------
+
+/**
+ * Stably merges two consecutive sorted ranges [first, middle) and [middle, last) into one
+ * sorted range [first, last) with a comparison function and a projection function, using
+ * the tuning constants of the given policy.
+ */
+template <
+    timsort_policy Policy,
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<Iterator, Compare, Projection>
+constexpr auto timmerge(Iterator first, Iterator middle, Sentinel last,
+                        Compare comp={}, Projection proj={})
+    -> Iterator
+{
+    auto last_it = std::ranges::next(first, last);
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, middle, comp, proj) && "Precondition");
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(middle, last_it, comp, proj) && "Precondition");
+    detail::TimSort<Iterator, void, Policy>::merge(first, middle, last_it, comp, proj);
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, last_it, comp, proj) && "Postcondition");
+    return last_it;
+}
+
+/**
+ * Stably merges two sorted halves [first, middle) and [middle, last) of a range into one
+ * sorted range [first, last) with a comparison function and a projection function, using
+ * the tuning constants of the given policy.
+ */
+template <
+    timsort_policy Policy,
+    std::ranges::random_access_range Range,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+constexpr auto timmerge(Range &&range, std::ranges::iterator_t<Range> middle,
+                        Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    return gfx::timmerge<Policy>(std::begin(range), middle, std::end(range), comp, proj);
+}
+
+/**
+ * Stably merges two consecutive sorted ranges [first, middle) and [middle, last) into one
+ * sorted range [first, last) with a comparison function and a projection function.
+ */
+template <
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<Iterator, Compare, Projection>
+constexpr auto timmerge(Iterator first, Iterator middle, Sentinel last,
+                        Compare comp={}, Projection proj={})
+    -> Iterator
+{
+    using policy_t = timsort_traits<std::iter_value_t<Iterator>>;
+    return gfx::timmerge<policy_t>(first, middle, last, comp, proj);
+}
+
+/**
+ * Stably merges two sorted halves [first, middle) and [middle, last) of a range into one
+ * sorted range [first, last) with a comparison function and a projection function.
+ */
+template <
+    std::ranges::random_access_range Range,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+constexpr auto timmerge(Range &&range, std::ranges::iterator_t<Range> middle,
+                        Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    return gfx::timmerge(std::begin(range), middle, std::end(range), comp, proj);
+}
+
+/**
+ * Stably merges two consecutive sorted ranges [first, middle) and [middle, last) into one
+ * sorted range [first, last) with a comparison function and a projection function, and
+ * accumulates statistics about the merge into a timsort_stats object or reports its
+ * phases to hooks.
+ */
+template <
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    timsort_observer Observer,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<Iterator, Compare, Projection>
+constexpr auto timmerge(Iterator first, Iterator middle, Sentinel last, Observer &observer,
+                        Compare comp={}, Projection proj={})
+    -> Iterator
+{
+    detail::stats_recorder<Observer> recorder{{}, &observer};
+    auto counted_comp = recorder.countComparisons(comp);
+
+    auto last_it = std::ranges::next(first, last);
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, middle, comp, proj) && "Precondition");
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(middle, last_it, comp, proj) && "Precondition");
+    detail::TimSort<Iterator, Observer>::merge(first, middle, last_it,
+                                               counted_comp, proj, recorder);
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, last_it, comp, proj) && "Postcondition");
+    return last_it;
+}
+
+/**
+ * Stably merges two sorted halves [first, middle) and [middle, last) of a range into one
+ * sorted range [first, last) with a comparison function and a projection function, and
+ * accumulates statistics about the merge into a timsort_stats object or reports its
+ * phases to hooks.
+ */
+template <
+    std::ranges::random_access_range Range,
+    timsort_observer Observer,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+constexpr auto timmerge(Range &&range, std::ranges::iterator_t<Range> middle,
+                        Observer &observer, Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    return gfx::timmerge(std::begin(range), middle, std::end(range), observer, comp, proj);
+}
+
+/**
+ * Stably sorts a range with a comparison function and a projection function, using the
+ * tuning constants of the given policy.
+ */
+template <
+    timsort_policy Policy,
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<Iterator, Compare, Projection>
+constexpr auto timsort(Iterator first, Sentinel last,
+                       Compare comp={}, Projection proj={})
+    -> Iterator
+{
+    auto last_it = std::ranges::next(first, last);
+    if constexpr (detail::lcp_sortable<Iterator, Compare, Projection>) {
+        // Strings sharing long prefixes sort faster when the common prefixes of
+        // neighbours are remembered
+        using lcp_sort_t = detail::LcpTimSort<Iterator, Projection, Policy>;
+        if (lcp_sort_t::worthwhile(first, last_it, proj)) {
+            lcp_sort_t::sort(first, last_it, proj);
+        } else {
+            detail::TimSort<Iterator, void, Policy>::sort(first, last_it, comp, proj);
+        }
+    } else if constexpr (detail::float_order_sortable<Iterator, Compare, Projection>) {
+        if (std::is_constant_evaluated() || last_it - first < detail::MIN_TOTAL_ORDER_KEYS) {
+            detail::TimSort<Iterator, void, Policy>::sort(first, last_it, comp, proj);
+        } else if constexpr (std::same_as<Compare, total_order_less>) {
+            detail::sortTotalOrderKeys<Policy>(first, last_it);
+        } else {
+            detail::sortNanLastKeys<Policy>(first, last_it, proj);
+        }
+    } else {
+        detail::TimSort<Iterator, void, Policy>::sort(first, last_it, comp, proj);
+    }
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, last_it, comp, proj) && "Postcondition");
+    return last_it;
+}
+
+/**
+ * Stably sorts a range with a comparison function and a projection function, using the
+ * tuning constants of the given policy.
+ */
+template <
+    timsort_policy Policy,
+    std::ranges::random_access_range Range,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+constexpr auto timsort(Range &&range, Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    using iter_t = std::ranges::iterator_t<Range>;
+    constexpr auto size = detail::static_size<std::remove_cvref_t<Range>>;
+
+    if constexpr (size >= 0 && !detail::lcp_sortable<iter_t, Compare, Projection>
+                  && !detail::float_order_sortable<iter_t, Compare, Projection>) {
+        // The size of C arrays, std::array and fixed-extent std::span is known
+        // at compile time
+        auto first = std::begin(range);
+        detail::TimSort<iter_t, void, Policy>::template sortFixed<size>(first, comp, proj);
+        GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, first + size, comp, proj)
+                          && "Postcondition");
+        return first + size;
+    } else {
+        return gfx::timsort<Policy>(std::begin(range), std::end(range), comp, proj);
+    }
+}
+
+/**
+ * Stably sorts a range with a comparison function and a projection function.
+ */
+template <
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<Iterator, Compare, Projection>
+constexpr auto timsort(Iterator first, Sentinel last,
+                       Compare comp={}, Projection proj={})
+    -> Iterator
+{
+    return gfx::timsort<timsort_traits<std::iter_value_t<Iterator>>>(first, last, comp, proj);
+}
+
+/**
+ * Stably sorts a range with a comparison function and a projection function.
+ */
+template <
+    std::ranges::random_access_range Range,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+constexpr auto timsort(Range &&range, Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    return gfx::timsort<timsort_traits<std::ranges::range_value_t<Range>>>(range, comp, proj);
+}
+
+/**
+ * Stably sorts a range with a comparison function and a projection function, and
+ * accumulates statistics about the sort into a timsort_stats object or reports its
+ * phases to hooks.
+ */
+template <
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    timsort_observer Observer,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<Iterator, Compare, Projection>
+constexpr auto timsort(Iterator first, Sentinel last, Observer &observer,
+                       Compare comp={}, Projection proj={})
+    -> Iterator
+{
+    detail::stats_recorder<Observer> recorder{{}, &observer};
+    auto counted_comp = recorder.countComparisons(comp);
+
+    auto last_it = std::ranges::next(first, last);
+    detail::TimSort<Iterator, Observer>::sort(first, last_it, counted_comp, proj, recorder);
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, last_it, comp, proj) && "Postcondition");
+    return last_it;
+}
+
+/**
+ * Stably sorts a range with a comparison function and a projection function, and
+ * accumulates statistics about the sort into a timsort_stats object or reports its
+ * phases to hooks.
+ */
+template <
+    std::ranges::random_access_range Range,
+    timsort_observer Observer,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+constexpr auto timsort(Range &&range, Observer &observer, Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    return gfx::timsort(std::begin(range), std::end(range), observer, comp, proj);
+}
+
+/**
+ * Stably sorts a range made of consecutive sorted runs with a comparison function and a
+ * projection function. The runs are delimited by the boundaries, a range of non-decreasing
+ * offsets into the range; the runs are merged without being scanned first.
+ */
+template <
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    std::ranges::input_range Boundaries,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<Iterator, Compare, Projection>
+          && std::integral<std::ranges::range_value_t<Boundaries>>
+constexpr auto timsort_runs(Iterator first, Sentinel last, Boundaries &&boundaries,
+                            Compare comp={}, Projection proj={})
+    -> Iterator
+{
+    using policy_t = timsort_traits<std::iter_value_t<Iterator>>;
+
+    auto last_it = std::ranges::next(first, last);
+    detail::TimSort<Iterator, void, policy_t>::sortGivenRuns(first, last_it, boundaries,
+                                                             comp, proj);
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, last_it, comp, proj) && "Postcondition");
+    return last_it;
+}
+
+/**
+ * Stably sorts a range made of consecutive sorted runs with a comparison function and a
+ * projection function. The runs are delimited by the boundaries, a range of non-decreasing
+ * offsets into the range.
+ */
+template <
+    std::ranges::random_access_range Range,
+    std::ranges::input_range Boundaries,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+          && std::integral<std::ranges::range_value_t<Boundaries>>
+constexpr auto timsort_runs(Range &&range, Boundaries &&boundaries,
+                            Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    return gfx::timsort_runs(std::begin(range), std::end(range),
+                             std::forward<Boundaries>(boundaries), comp, proj);
+}
+
+/**
+ * Stably sorts a range [first, last) whose elements in [first, middle) are already sorted
+ * with a comparison function and a projection function: only [middle, last) is scanned for
+ * runs, then everything is merged.
+ */
+template <
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<Iterator, Compare, Projection>
+constexpr auto timsort_tail(Iterator first, Iterator middle, Sentinel last,
+                            Compare comp={}, Projection proj={})
+    -> Iterator
+{
+    using policy_t = timsort_traits<std::iter_value_t<Iterator>>;
+
+    auto last_it = std::ranges::next(first, last);
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, middle, comp, proj) && "Precondition");
+    detail::TimSort<Iterator, void, policy_t>::sortTail(first, middle, last_it, comp, proj);
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, last_it, comp, proj) && "Postcondition");
+    return last_it;
+}
+
+/**
+ * Stably sorts a range whose elements before middle are already sorted with a comparison
+ * function and a projection function.
+ */
+template <
+    std::ranges::random_access_range Range,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+constexpr auto timsort_tail(Range &&range, std::ranges::iterator_t<Range> middle,
+                            Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    return gfx::timsort_tail(std::begin(range), middle, std::end(range), comp, proj);
+}
+
+/**
+ * Stably sorts every range of a batch of independent ranges with a comparison function and a
+ * projection function. The sorts share their temporary storage, and the ranges too small to
+ * be merged are sorted before the bigger ones.
+ */
+template <
+    std::ranges::random_access_range Ranges,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::ranges::random_access_range<std::ranges::range_reference_t<Ranges>>
+          && std::sortable<detail::batch_iterator_t<Ranges>, Compare, Projection>
+constexpr auto timsort_batch(Ranges &&ranges, Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Ranges>
+{
+    using iter_t = detail::batch_iterator_t<Ranges>;
+    using policy_t = timsort_traits<std::iter_value_t<iter_t>>;
+
+    auto first = std::ranges::begin(ranges);
+    auto last = std::ranges::next(first, std::ranges::end(ranges));
+    detail::TimSort<iter_t, void, policy_t>::sortBatch(first, last, comp, proj);
+    GFX_TIMSORT_AUDIT(std::ranges::all_of(first, last, [&](auto &&range) {
+        return std::ranges::is_sorted(range, comp, proj);
+    }) && "Postcondition");
+    return last;
+}
+
+/**
+ * Stably sorts every segment of a range stored in CSR layout with a comparison function and a
+ * projection function: the i-th segment spans the offsets [offsets[i], offsets[i + 1]) of the
+ * range, the offsets being non-decreasing. The segments are sorted like the ranges of
+ * timsort_batch.
+ */
+template <
+    std::ranges::random_access_range Range,
+    std::ranges::random_access_range Offsets,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+          && std::integral<std::ranges::range_value_t<Offsets>>
+auto timsort_segmented(Range &&range, Offsets &&offsets, Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    auto first = std::ranges::begin(range);
+    auto last = std::ranges::next(first, std::ranges::end(range));
+    gfx::timsort_batch(detail::segments(first, last, offsets), comp, proj);
+    return last;
+}
+
+/**
+ * Returns the permutation that stably sorts a range with a comparison function and a
+ * projection function, without modifying the range: the i-th element of the sorted range
+ * is the element at index perm[i] of the original range.
+ */
+template <
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::indirect_strict_weak_order<Compare, std::projected<Iterator, Projection>>
+auto timsort_indices(Iterator first, Sentinel last,
+                     Compare comp={}, Projection proj={})
+    -> std::vector<std::iter_difference_t<Iterator>>
+{
+    using diff_t = std::iter_difference_t<Iterator>;
+    using index_iter_t = typename std::vector<diff_t>::iterator;
+
+    std::vector<diff_t> indices(static_cast<std::size_t>(std::ranges::distance(first, last)));
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        indices[i] = static_cast<diff_t>(i);
+    }
+
+    auto index_proj = [&first, &proj](diff_t index) -> decltype(auto) {
+        return std::invoke(proj, first[index]);
+    };
+    // Tune for the elements, not for the indices, which are cheap to compare
+    using policy_t = timsort_traits<std::iter_value_t<Iterator>>;
+    detail::TimSort<index_iter_t, void, policy_t>::sort(indices.begin(), indices.end(),
+                                                        comp, index_proj);
+    return indices;
+}
+
+/**
+ * Returns the permutation that stably sorts a range with a comparison function and a
+ * projection function, without modifying the range.
+ */
+template <
+    std::ranges::random_access_range Range,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::indirect_strict_weak_order<
+        Compare,
+        std::projected<std::ranges::iterator_t<Range>, Projection>
+    >
+auto timsort_indices(Range &&range, Compare comp={}, Projection proj={})
+    -> std::vector<std::ranges::range_difference_t<Range>>
+{
+    return gfx::timsort_indices(std::begin(range), std::end(range), comp, proj);
+}
+
+/**
+ * Reorders a range in place so that its i-th element becomes the element previously at
+ * index perm[i], where perm is a permutation such as the ones returned by timsort_indices.
+ * The cycles of the permutation are followed so that every element is moved exactly once,
+ * plus one move in and out of a temporary per cycle.
+ */
+template <
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    std::ranges::random_access_range Permutation
+>
+    requires std::permutable<Iterator>
+          && std::integral<std::ranges::range_value_t<Permutation>>
+auto apply_permutation(Iterator first, Sentinel last, Permutation &&perm)
+    -> Iterator
+{
+    using diff_t = std::iter_difference_t<Iterator>;
+
+    auto last_it = std::ranges::next(first, last);
+    diff_t const size = last_it - first;
+    GFX_TIMSORT_ASSERT(std::ranges::ssize(perm) == size);
+    GFX_TIMSORT_AUDIT(std::ranges::is_permutation(perm, std::views::iota(diff_t(0), size))
+                      && "Precondition");
+
+    detail::applyPermutation(first, size, std::ranges::begin(perm));
+    return last_it;
+}
+
+/**
+ * Reorders a range in place so that its i-th element becomes the element previously at
+ * index perm[i], where perm is a permutation such as the ones returned by timsort_indices.
+ */
+template <
+    std::ranges::random_access_range Range,
+    std::ranges::random_access_range Permutation
+>
+    requires std::permutable<std::ranges::iterator_t<Range>>
+          && std::integral<std::ranges::range_value_t<Permutation>>
+auto apply_permutation(Range &&range, Permutation &&perm)
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    return gfx::apply_permutation(std::begin(range), std::end(range),
+                                  std::forward<Permutation>(perm));
+}
+
+/**
+ * Abbreviation function mapping integers, floating-point values and the first bytes of narrow
+ * strings to unsigned 64-bit integers ordered like the values they abbreviate with
+ * std::ranges::less: for any values such that !(b < a), abbreviate(a) <= abbreviate(b).
+ */
+struct abbreviate {
+    template <std::integral T>
+        requires (sizeof(T) <= sizeof(std::uint64_t))
+    constexpr auto operator()(T value) const noexcept
+        -> std::uint64_t
+    {
+        if constexpr (std::is_signed_v<T>) {
+            // Flip the sign bit so that negative values come first
+            return static_cast<std::uint64_t>(static_cast<std::int64_t>(value))
+                 ^ (std::uint64_t(1) << 63);
+        } else {
+            return static_cast<std::uint64_t>(value);
+        }
+    }
+
+    template <std::floating_point T>
+        requires detail::iec559_binary<T>
+    constexpr auto operator()(T value) const noexcept
+        -> std::uint64_t
+    {
+        // Consistent with both operator< and the IEEE 754 total order; -0 and +0 are equal
+        // for operator<, so they have to get the same key
+        return detail::totalOrderKey(value == T(0) ? T(0) : value);
+    }
+
+    template <typename Char>
+        requires (sizeof(Char) == 1)
+    constexpr auto operator()(std::basic_string_view<Char> str) const noexcept
+        -> std::uint64_t
+    {
+        // The standard traits compare narrow characters as unsigned char; the first
+        // eight of them are packed big-endian, shorter strings are padded with zeros
+        std::uint64_t res = 0;
+        for (std::size_t i = 0; i < sizeof(std::uint64_t); ++i) {
+            res <<= 8;
+            if (i < str.size()) {
+                res |= static_cast<unsigned char>(str[i]);
+            }
+        }
+        return res;
+    }
+
+    template <typename Char, typename Allocator>
+        requires (sizeof(Char) == 1)
+    constexpr auto operator()(std::basic_string<Char, std::char_traits<Char>,
+                                                Allocator> const& str) const noexcept
+        -> std::uint64_t
+    {
+        return (*this)(std::basic_string_view<Char>(str));
+    }
+};
+
+namespace detail {
+
+// Placeholder abbreviation that can't be called, the default of gfx::timsort_abbreviated for
+// the comparisons gfx::abbreviate isn't consistent with
+struct no_default_abbreviation {};
+
+template <typename Compare, typename Iter, typename Projection>
+using default_abbreviation_t = std::conditional_t<
+    std::same_as<Compare, std::ranges::less> || std::same_as<Compare, std::less<>>
+    || std::same_as<Compare, std::less<projected_key_t<Iter, Projection>>>,
+    gfx::abbreviate,
+    no_default_abbreviation
+>;
+
+} // namespace detail
+
+/**
+ * Stably sorts a range with a comparison function and a projection function, comparing the
+ * abbreviations of the projected elements before calling the comparison function: only the
+ * elements whose abbreviations are equal are compared. The abbreviation function maps the
+ * projected elements to unsigned 64-bit integers and has to be consistent with the comparison
+ * function, equivalent elements included: if !comp(b, a) then abbrev(a) <= abbrev(b). It
+ * defaults to gfx::abbreviate for ascending comparisons, and has to be given for the other ones.
+ */
+template <
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity,
+    typename Abbreviation = detail::default_abbreviation_t<Compare, Iterator, Projection>
+>
+    requires std::sortable<Iterator, Compare, Projection>
+          && std::regular_invocable<Abbreviation&, std::indirect_result_t<Projection&, Iterator>>
+          && std::convertible_to<
+                 std::invoke_result_t<Abbreviation&,
+                                      std::indirect_result_t<Projection&, Iterator>>,
+                 std::uint64_t
+             >
+auto timsort_abbreviated(Iterator first, Sentinel last, Compare comp={}, Projection proj={},
+                         Abbreviation abbrev={})
+    -> Iterator
+{
+    using diff_t = std::iter_difference_t<Iterator>;
+    using entry_t = detail::abbreviated_entry<diff_t>;
+    using entry_iter_t = typename std::vector<entry_t>::iterator;
+
+    auto last_it = std::ranges::next(first, last);
+    std::vector<entry_t> entries;
+    entries.reserve(static_cast<std::size_t>(last_it - first));
+    for (diff_t i = 0; i < last_it - first; ++i) {
+        auto const key = static_cast<std::uint64_t>(std::invoke(abbrev,
+                                                                std::invoke(proj, first[i])));
+        entries.push_back({ key, i });
+    }
+
+    // The abbreviations sit next to the indices, the elements are only accessed on ties
+    auto entry_comp = [&first, &comp, &proj](entry_t const& lhs, entry_t const& rhs) {
+        if (lhs.key != rhs.key) {
+            return lhs.key < rhs.key;
+        }
+        return static_cast<bool>(std::invoke(comp, std::invoke(proj, first[lhs.index]),
+                                                   std::invoke(proj, first[rhs.index])));
+    };
+    // Tune for the elements, whose comparisons are the expensive ones
+    using policy_t = timsort_traits<std::iter_value_t<Iterator>>;
+    detail::TimSort<entry_iter_t, void, policy_t>::sort(entries.begin(), entries.end(),
+                                                        entry_comp, std::identity{});
+
+    gfx::apply_permutation(first, last_it, std::views::transform(entries, &entry_t::index));
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, last_it, comp, proj)
+                      && "Postcondition, is the abbreviation consistent with the comparison?");
+    return last_it;
+}
+
+/**
+ * Stably sorts a range with a comparison function and a projection function, comparing the
+ * abbreviations of the projected elements before calling the comparison function.
+ */
+template <
+    std::ranges::random_access_range Range,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity,
+    typename Abbreviation = detail::default_abbreviation_t<
+        Compare, std::ranges::iterator_t<Range>, Projection
+    >
+>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+          && std::regular_invocable<
+                 Abbreviation&,
+                 std::indirect_result_t<Projection&, std::ranges::iterator_t<Range>>
+             >
+          && std::convertible_to<
+                 std::invoke_result_t<
+                     Abbreviation&,
+                     std::indirect_result_t<Projection&, std::ranges::iterator_t<Range>>
+                 >,
+                 std::uint64_t
+             >
+auto timsort_abbreviated(Range &&range, Compare comp={}, Projection proj={},
+                         Abbreviation abbrev={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    return gfx::timsort_abbreviated(std::begin(range), std::end(range), comp, proj, abbrev);
+}
+
+/**
+ * Stably sorts a range of keys with a comparison function, and reorders one or more ranges
+ * of values the same way: the i-th element of every range of values moves along with the
+ * i-th key. The comparison function, if any, is the last argument. Only the keys are
+ * compared, and every range gets its own temporary storage.
+ */
+template <std::ranges::random_access_range Keys, typename... Args>
+    requires (sizeof...(Args) > 0)
+          && detail::by_key_arguments<Keys, std::tuple<Args...>>
+auto timsort_by_key(Keys &&keys, Args &&...args)
+    -> std::ranges::borrowed_iterator_t<Keys>
+{
+    auto first = std::ranges::begin(keys);
+    auto last = std::ranges::next(first, std::ranges::end(keys));
+
+    auto sort = [&]<typename Compare, typename... Values>(Compare comp, Values &...values) {
+        GFX_TIMSORT_ASSERT(((std::ranges::distance(values) >= last - first) && ...));
+        using iter_t = decltype(first);
+        using policy_t = timsort_traits<std::iter_value_t<iter_t>>;
+        using moves_t = detail::by_key_moves<detail::merge_buffer_bytes<policy_t>, iter_t,
+                                             std::ranges::iterator_t<Values>...>;
+        detail::TimSort<iter_t, void, policy_t, moves_t>::sort(
+            first, last, comp, std::identity{}, {}, first, std::ranges::begin(values)...);
+        GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, last, comp) && "Postcondition");
+    };
+
+    if constexpr (detail::by_key_sortable<Keys, std::ranges::less, Args...>) {
+        sort(std::ranges::less{}, args...);
+    } else {
+        // The comparison function is the last argument
+        auto arguments = std::forward_as_tuple(args...);
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            sort(std::get<sizeof...(I)>(arguments), std::get<I>(arguments)...);
+        }(std::make_index_sequence<sizeof...(Args) - 1>{});
+    }
+    return last;
+}
+
+/**
+ * Stably sorts a list providing std::list-like splice operations with a comparison function
+ * and a projection function, using the tuning constants of the given policy. The nodes are
+ * relinked: the elements are never moved nor copied.
+ */
+template <
+    timsort_policy Policy,
+    std::ranges::bidirectional_range List,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires (!std::ranges::random_access_range<List>)
+          && detail::spliceable_list<List>
+          && std::indirect_strict_weak_order<
+              Compare,
+              std::projected<std::ranges::iterator_t<List>, Projection>
+          >
+auto timsort(List &list, Compare comp={}, Projection proj={})
+    -> std::ranges::iterator_t<List>
+{
+    using links_t = detail::list_links<List>;
+    detail::ListTimSort<links_t, Policy>::sort(links_t{&list}, std::ranges::begin(list),
+                                               std::ranges::distance(list), comp, proj);
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(list, comp, proj) && "Postcondition");
+    return std::ranges::end(list);
+}
+
+/**
+ * Stably sorts a list providing std::list-like splice operations with a comparison function
+ * and a projection function. The nodes are relinked: the elements are never moved nor copied.
+ */
+template <
+    std::ranges::bidirectional_range List,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires (!std::ranges::random_access_range<List>)
+          && detail::spliceable_list<List>
+          && std::indirect_strict_weak_order<
+              Compare,
+              std::projected<std::ranges::iterator_t<List>, Projection>
+          >
+auto timsort(List &list, Compare comp={}, Projection proj={})
+    -> std::ranges::iterator_t<List>
+{
+    using policy_t = timsort_traits<std::ranges::range_value_t<List>>;
+    return gfx::timsort<policy_t>(list, comp, proj);
+}
 
-        minGallop_ = (std::min)(minGallop, 1);
+/**
+ * Describes how to access and modify the links of the nodes of an intrusive doubly linked
+ * list. A null pointer is accepted as the previous node of the first node, or as the next
+ * node of the last one.
+ */
+template <typename Hook, typename Node>
+concept list_hook = requires (Hook const& hook, Node* node) {
+    { hook.next(node) } -> std::convertible_to<Node*>;
+    { hook.prev(node) } -> std::convertible_to<Node*>;
+    hook.set_next(node, node);
+    hook.set_prev(node, node);
+};
 
-        if (len2 == 1) {
-            GFX_TIMSORT_ASSERT(len1 > 0);
-            dest -= len1;
-            std::ranges::move_backward(cursor1 - len1, cursor1, dest + (1 + len1));
-            *dest = std::ranges::iter_move(cursor2);
-        } else {
-            GFX_TIMSORT_ASSERT(len2 != 0 && "Comparison function violates its general contract");
-            GFX_TIMSORT_ASSERT(len1 == 0);
-            GFX_TIMSORT_ASSERT(len2 > 1);
-            std::ranges::move(tmp_.begin(), tmp_.begin() + len2, dest - (len2 - 1));
-        }
+/**
+ * List hook for nodes storing pointers to their neighbours in the data members Next and Prev.
+ */
+template <auto Next, auto Prev>
+struct list_member_hook {
+    template <typename Node>
+    Node* next(Node* node) const {
+        return node->*Next;
     }
 
-    void move_to_tmp(iter_t const begin, diff_t len) {
-        tmp_.assign(std::make_move_iterator(begin),
-                    std::make_move_iterator(begin + len));
+    template <typename Node>
+    Node* prev(Node* node) const {
+        return node->*Prev;
     }
 
-public:
+    template <typename Node>
+    void set_next(Node* node, Node* next) const {
+        node->*Next = next;
+    }
 
-    template <typename Compare, typename Projection>
-    static void merge(iter_t const lo, iter_t const mid, iter_t const hi,
-                      Compare comp, Projection proj) {
-        GFX_TIMSORT_ASSERT(lo <= mid);
-        GFX_TIMSORT_ASSERT(mid <= hi);
+    template <typename Node>
+    void set_prev(Node* node, Node* prev) const {
+        node->*Prev = prev;
+    }
+};
 
-        if (lo == mid || mid == hi) {
-            return; // nothing to do
-        }
+/**
+ * Stably sorts the nodes [first, last) of an intrusive doubly linked list by relinking them,
+ * with a comparison function and a projection function applied to the nodes, using the
+ * tuning constants of the given policy. The nodes surrounding the range are relinked
+ * accordingly. Returns the new first node of the range.
+ */
+template <
+    timsort_policy Policy,
+    typename Node,
+    typename Hook,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires list_hook<Hook, Node>
+          && std::indirect_strict_weak_order<Compare, std::projected<Node*, Projection>>
+auto timsort_list(Node *first, Node *last, Hook hook,
+                  Compare comp={}, Projection proj={})
+    -> Node*
+{
+    std::ptrdiff_t size = 0;
+    for (Node* node = first; node != last; node = hook.next(node)) {
+        ++size;
+    }
 
-        TimSort ts;
-        ts.mergeConsecutiveRuns(lo, mid - lo, mid, hi - mid, std::move(comp), std::move(proj));
+    using links_t = detail::node_links<Node, Hook>;
+    return detail::ListTimSort<links_t, Policy>::sort(links_t{hook}, first, size, comp, proj);
+}
 
-        GFX_TIMSORT_LOG("1st size: " << (mid - lo) << "; 2nd size: " << (hi - mid)
-                                     << "; tmp_.size(): " << ts.tmp_.size());
-    }
+/**
+ * Stably sorts the nodes [first, last) of an intrusive doubly linked list by relinking them,
+ * with a comparison function and a projection function applied to the nodes. The nodes
+ * surrounding the range are relinked accordingly. Returns the new first node of the range.
+ */
+template <
+    typename Node,
+    typename Hook,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires list_hook<Hook, Node>
+          && std::indirect_strict_weak_order<Compare, std::projected<Node*, Projection>>
+auto timsort_list(Node *first, Node *last, Hook hook,
+                  Compare comp={}, Projection proj={})
+    -> Node*
+{
+    return gfx::timsort_list<timsort_traits<Node>>(first, last, hook, comp, proj);
+}
 
-    template <typename Compare, typename Projection>
-    static void sort(iter_t const lo, iter_t const hi, Compare comp, Projection proj) {
-        GFX_TIMSORT_ASSERT(lo <= hi);
+/**
+ * Returns an iterator to the first element of a sorted range not less than key, with a
+ * comparison function and a projection function. The search starts at hint and expands
+ * exponentially from there, so it needs O(log d) comparisons where d is the distance
+ * between hint and the result.
+ */
+template <
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    typename T,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::indirect_strict_weak_order<
+        Compare,
+        T const*,
+        std::projected<Iterator, Projection>
+    >
+constexpr auto gallop_lower_bound(Iterator first, Sentinel last, T const& key, Iterator hint,
+                                  Compare comp={}, Projection proj={})
+    -> Iterator
+{
+    using diff_t = std::iter_difference_t<Iterator>;
 
-        auto nRemaining = hi - lo;
-        if (nRemaining < 2) {
-            return; // nothing to do
-        }
+    auto last_it = std::ranges::next(first, last);
+    diff_t const len = last_it - first;
+    if (len == 0) {
+        return first;
+    }
+    diff_t const offset = std::clamp(diff_t(hint - first), diff_t(0), diff_t(len - 1));
+    return first + detail::gallopLeft(key, first, len, offset, comp, proj);
+}
 
-        if (nRemaining < MIN_MERGE) {
-            auto initRunLen = countRunAndMakeAscending(lo, hi, comp, proj);
-            GFX_TIMSORT_LOG("initRunLen: " << initRunLen);
-            binarySort(lo, hi, lo + initRunLen, comp, proj);
-            return;
-        }
+/**
+ * Returns an iterator to the first element of a sorted range not less than key, with a
+ * comparison function and a projection function, searching exponentially from hint.
+ */
+template <
+    std::ranges::random_access_range Range,
+    typename T,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::indirect_strict_weak_order<
+        Compare,
+        T const*,
+        std::projected<std::ranges::iterator_t<Range>, Projection>
+    >
+constexpr auto gallop_lower_bound(Range &&range, T const& key, std::ranges::iterator_t<Range> hint,
+                                  Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    return gfx::gallop_lower_bound(std::begin(range), std::end(range), key, hint, comp, proj);
+}
 
-        TimSort ts;
-        auto minRun = minRunLength(nRemaining);
-        auto cur = lo;
-        do {
-            auto runLen = countRunAndMakeAscending(cur, hi, comp, proj);
+/**
+ * Returns an iterator to the first element of a sorted range greater than key, with a
+ * comparison function and a projection function. The search starts at hint and expands
+ * exponentially from there, so it needs O(log d) comparisons where d is the distance
+ * between hint and the result.
+ */
+template <
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    typename T,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::indirect_strict_weak_order<
+        Compare,
+        T const*,
+        std::projected<Iterator, Projection>
+    >
+constexpr auto gallop_upper_bound(Iterator first, Sentinel last, T const& key, Iterator hint,
+                                  Compare comp={}, Projection proj={})
+    -> Iterator
+{
+    using diff_t = std::iter_difference_t<Iterator>;
 
-            if (runLen < minRun) {
-                auto force = (std::min)(nRemaining, minRun);
-                binarySort(cur, cur + force, cur + runLen, comp, proj);
-                runLen = force;
-            }
+    auto last_it = std::ranges::next(first, last);
+    diff_t const len = last_it - first;
+    if (len == 0) {
+        return first;
+    }
+    diff_t const offset = std::clamp(diff_t(hint - first), diff_t(0), diff_t(len - 1));
+    return first + detail::gallopRight(key, first, len, offset, comp, proj);
+}
 
-            ts.pushRun(cur, runLen);
-            ts.mergeCollapse(comp, proj);
+/**
+ * Returns an iterator to the first element of a sorted range greater than key, with a
+ * comparison function and a projection function, searching exponentially from hint.
+ */
+template <
+    std::ranges::random_access_range Range,
+    typename T,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::indirect_strict_weak_order<
+        Compare,
+        T const*,
+        std::projected<std::ranges::iterator_t<Range>, Projection>
+    >
+constexpr auto gallop_upper_bound(Range &&range, T const& key, std::ranges::iterator_t<Range> hint,
+                                  Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    return gfx::gallop_upper_bound(std::begin(range), std::end(range), key, hint, comp, proj);
+}
 
-            cur += runLen;
-            nRemaining -= runLen;
-        } while (nRemaining != 0);
+namespace detail {
 
-        GFX_TIMSORT_ASSERT(cur == hi);
-        ts.mergeForceCollapse(comp, proj);
-        GFX_TIMSORT_ASSERT(ts.pending_.size() == 1);
+template <
+    bool Upper,
+    typename Iterator, typename KeyIterator, typename KeySentinel,
+    typename OutputIterator, typename Compare, typename Projection
+>
+constexpr auto gallopBoundBatch(Iterator first, Iterator last,
+                                KeyIterator keys_first, KeySentinel keys_last,
+                                OutputIterator result, Compare comp, Projection proj)
+    -> std::ranges::in_out_result<KeyIterator, OutputIterator>
+{
+    using diff_t = std::iter_difference_t<Iterator>;
 
-        GFX_TIMSORT_LOG("size: " << (hi - lo) << " tmp_.size(): " << ts.tmp_.size()
-                                 << " pending_.size(): " << ts.pending_.size());
+    diff_t const len = last - first;
+    diff_t pos = 0;
+    for (; keys_first != keys_last; ++keys_first) {
+        if (len != 0) {
+            // The previous result is the hint for the next search
+            diff_t const hint = (std::min)(pos, diff_t(len - 1));
+            if constexpr (Upper) {
+                pos = gallopRight(*keys_first, first, len, hint, comp, proj);
+            } else {
+                pos = gallopLeft(*keys_first, first, len, hint, comp, proj);
+            }
+        }
+        *result = first + pos;
+        ++result;
     }
-};
+    return { std::move(keys_first), std::move(result) };
+}
 
 } // namespace detail
 
-
-// ---------------------------------------
-// Public interface implementation
-// ---------------------------------------
-
 /**
- * Stably merges two consecutive sorted ranges [first, middle) and [middle, last) into one
- * sorted range [first, last) with a comparison function and a projection function.
+ * Writes to result, for every key of a sorted range of keys, an iterator to the first element
+ * of a sorted range not less than the key. Every search uses the result of the previous one
+ * as a hint, so looking up m keys needs O(m log(n/m)) comparisons.
  */
 template <
     std::random_access_iterator Iterator,
     std::sentinel_for<Iterator> Sentinel,
+    std::input_iterator KeyIterator,
+    std::sentinel_for<KeyIterator> KeySentinel,
+    std::weakly_incrementable OutputIterator,
     typename Compare = std::ranges::less,
     typename Projection = std::identity
 >
-    requires std::sortable<Iterator, Compare, Projection>
-auto timmerge(Iterator first, Iterator middle, Sentinel last,
-              Compare comp={}, Projection proj={})
-    -> Iterator
+    requires std::indirect_strict_weak_order<
+        Compare,
+        KeyIterator,
+        std::projected<Iterator, Projection>
+    > && std::indirectly_writable<OutputIterator, Iterator>
+constexpr auto gallop_lower_bound_batch(Iterator first, Sentinel last,
+                                        KeyIterator keys_first, KeySentinel keys_last,
+                                        OutputIterator result, Compare comp={}, Projection proj={})
+    -> std::ranges::in_out_result<KeyIterator, OutputIterator>
 {
     auto last_it = std::ranges::next(first, last);
-    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, middle, comp, proj) && "Precondition");
-    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(middle, last_it, comp, proj) && "Precondition");
-    detail::TimSort<Iterator>::merge(first, middle, last_it, comp, proj);
-    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, last_it, comp, proj) && "Postcondition");
-    return last_it;
+    return detail::gallopBoundBatch<false>(first, last_it, std::move(keys_first), keys_last,
+                                           std::move(result), comp, proj);
 }
 
 /**
- * Stably merges two sorted halves [first, middle) and [middle, last) of a range into one
- * sorted range [first, last) with a comparison function and a projection function.
+ * Writes to result, for every key of a sorted range of keys, an iterator to the first element
+ * of a sorted range not less than the key, using the previous result as a hint.
  */
 template <
     std::ranges::random_access_range Range,
+    std::ranges::input_range Keys,
+    std::weakly_incrementable OutputIterator,
     typename Compare = std::ranges::less,
     typename Projection = std::identity
 >
-    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
-auto timmerge(Range &&range, std::ranges::iterator_t<Range> middle,
-              Compare comp={}, Projection proj={})
-    -> std::ranges::borrowed_iterator_t<Range>
+    requires std::indirect_strict_weak_order<
+        Compare,
+        std::ranges::iterator_t<Keys>,
+        std::projected<std::ranges::iterator_t<Range>, Projection>
+    > && std::indirectly_writable<OutputIterator, std::ranges::iterator_t<Range>>
+constexpr auto gallop_lower_bound_batch(Range &&range, Keys &&keys, OutputIterator result,
+                                        Compare comp={}, Projection proj={})
+    -> std::ranges::in_out_result<std::ranges::borrowed_iterator_t<Keys>, OutputIterator>
 {
-    return gfx::timmerge(std::begin(range), middle, std::end(range), comp, proj);
+    return gfx::gallop_lower_bound_batch(std::begin(range), std::end(range),
+                                         std::ranges::begin(keys), std::ranges::end(keys),
+                                         std::move(result), comp, proj);
 }
 
 /**
- * Stably sorts a range with a comparison function and a projection function.
+ * Writes to result, for every key of a sorted range of keys, an iterator to the first element
+ * of a sorted range greater than the key. Every search uses the result of the previous one
+ * as a hint, so looking up m keys needs O(m log(n/m)) comparisons.
  */
 template <
     std::random_access_iterator Iterator,
     std::sentinel_for<Iterator> Sentinel,
+    std::input_iterator KeyIterator,
+    std::sentinel_for<KeyIterator> KeySentinel,
+    std::weakly_incrementable OutputIterator,
     typename Compare = std::ranges::less,
     typename Projection = std::identity
 >
-    requires std::sortable<Iterator, Compare, Projection>
-auto timsort(Iterator first, Sentinel last,
-             Compare comp={}, Projection proj={})
-    -> Iterator
+    requires std::indirect_strict_weak_order<
+        Compare,
+        KeyIterator,
+        std::projected<Iterator, Projection>
+    > && std::indirectly_writable<OutputIterator, Iterator>
+constexpr auto gallop_upper_bound_batch(Iterator first, Sentinel last,
+                                        KeyIterator keys_first, KeySentinel keys_last,
+                                        OutputIterator result, Compare comp={}, Projection proj={})
+    -> std::ranges::in_out_result<KeyIterator, OutputIterator>
 {
     auto last_it = std::ranges::next(first, last);
-    detail::TimSort<Iterator>::sort(first, last_it, comp, proj);
-    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first, last_it, comp, proj) && "Postcondition");
-    return last_it;
+    return detail::gallopBoundBatch<true>(first, last_it, std::move(keys_first), keys_last,
+                                          std::move(result), comp, proj);
 }
 
 /**
- * Stably sorts a range with a comparison function and a projection function.
+ * Writes to result, for every key of a sorted range of keys, an iterator to the first element
+ * of a sorted range greater than the key, using the previous result as a hint.
  */
 template <
     std::ranges::random_access_range Range,
+    std::ranges::input_range Keys,
+    std::weakly_incrementable OutputIterator,
     typename Compare = std::ranges::less,
     typename Projection = std::identity
 >
-    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
-auto timsort(Range &&range, Compare comp={}, Projection proj={})
-    -> std::ranges::borrowed_iterator_t<Range>
+    requires std::indirect_strict_weak_order<
+        Compare,
+        std::ranges::iterator_t<Keys>,
+        std::projected<std::ranges::iterator_t<Range>, Projection>
+    > && std::indirectly_writable<OutputIterator, std::ranges::iterator_t<Range>>
+constexpr auto gallop_upper_bound_batch(Range &&range, Keys &&keys, OutputIterator result,
+                                        Compare comp={}, Projection proj={})
+    -> std::ranges::in_out_result<std::ranges::borrowed_iterator_t<Keys>, OutputIterator>
+{
+    return gfx::gallop_upper_bound_batch(std::begin(range), std::end(range),
+                                         std::ranges::begin(keys), std::ranges::end(keys),
+                                         std::move(result), comp, proj);
+}
+
+/*
+ * The following set operations are drop-in replacements for the standard ones, with the
+ * difference that they require random-access iterators: they walk both ranges like mergeLo,
+ * and switch to galloping when elements from one of the ranges keep coming first, which
+ * needs O(m log(n/m)) comparisons instead of O(n + m) when the inputs barely overlap or have
+ * very different sizes.
+ */
+
+/**
+ * Computes the sorted union of two sorted ranges with a comparison function and projection
+ * functions, galloping over the chunks of elements found in only one of them.
+ */
+template <
+    std::random_access_iterator Iterator1,
+    std::sentinel_for<Iterator1> Sentinel1,
+    std::random_access_iterator Iterator2,
+    std::sentinel_for<Iterator2> Sentinel2,
+    std::weakly_incrementable OutputIterator,
+    typename Compare = std::ranges::less,
+    typename Projection1 = std::identity,
+    typename Projection2 = std::identity
+>
+    requires std::mergeable<Iterator1, Iterator2, OutputIterator, Compare, Projection1, Projection2>
+auto timset_union(Iterator1 first1, Sentinel1 last1, Iterator2 first2, Sentinel2 last2,
+                  OutputIterator result, Compare comp={},
+                  Projection1 proj1={}, Projection2 proj2={})
+    -> std::ranges::set_union_result<Iterator1, Iterator2, OutputIterator>
+{
+    auto last1_it = std::ranges::next(first1, last1);
+    auto last2_it = std::ranges::next(first2, last2);
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first1, last1_it, comp, proj1) && "Precondition");
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first2, last2_it, comp, proj2) && "Precondition");
+    detail::gallopWalk<timsort_traits<std::iter_value_t<Iterator1>>>(
+        first1, last1_it, first2, last2_it, comp, proj1, proj2,
+        [&result](Iterator1 it, std::iter_difference_t<Iterator1> count) {
+            result = std::ranges::copy_n(it, count, std::move(result)).out;
+        },
+        [&result](Iterator2 it, std::iter_difference_t<Iterator2> count) {
+            result = std::ranges::copy_n(it, count, std::move(result)).out;
+        },
+        [&result](Iterator1& it1, Iterator2& it2) {
+            *result = *it1;
+            ++result;
+            ++it1;
+            ++it2;
+        }
+    );
+    auto [in1, out1] = std::ranges::copy(std::move(first1), std::move(last1_it),
+                                         std::move(result));
+    auto [in2, out2] = std::ranges::copy(std::move(first2), std::move(last2_it),
+                                         std::move(out1));
+    return { std::move(in1), std::move(in2), std::move(out2) };
+}
+
+/**
+ * Computes the sorted union of two sorted ranges with a comparison function and projection
+ * functions, galloping over the chunks of elements found in only one of them.
+ */
+template <
+    std::ranges::random_access_range Range1,
+    std::ranges::random_access_range Range2,
+    std::weakly_incrementable OutputIterator,
+    typename Compare = std::ranges::less,
+    typename Projection1 = std::identity,
+    typename Projection2 = std::identity
+>
+    requires std::mergeable<
+        std::ranges::iterator_t<Range1>,
+        std::ranges::iterator_t<Range2>,
+        OutputIterator, Compare, Projection1, Projection2
+    >
+auto timset_union(Range1 &&range1, Range2 &&range2, OutputIterator result,
+                  Compare comp={}, Projection1 proj1={}, Projection2 proj2={})
+    -> std::ranges::set_union_result<
+        std::ranges::borrowed_iterator_t<Range1>,
+        std::ranges::borrowed_iterator_t<Range2>,
+        OutputIterator
+    >
+{
+    return gfx::timset_union(std::begin(range1), std::end(range1),
+                              std::begin(range2), std::end(range2),
+                              std::move(result), comp, proj1, proj2);
+}
+
+/**
+ * Computes the sorted intersection of two sorted ranges with a comparison function and
+ * projection functions, galloping over the chunks of elements found in only one of them.
+ */
+template <
+    std::random_access_iterator Iterator1,
+    std::sentinel_for<Iterator1> Sentinel1,
+    std::random_access_iterator Iterator2,
+    std::sentinel_for<Iterator2> Sentinel2,
+    std::weakly_incrementable OutputIterator,
+    typename Compare = std::ranges::less,
+    typename Projection1 = std::identity,
+    typename Projection2 = std::identity
+>
+    requires std::mergeable<Iterator1, Iterator2, OutputIterator, Compare, Projection1, Projection2>
+auto timset_intersection(Iterator1 first1, Sentinel1 last1,
+                         Iterator2 first2, Sentinel2 last2,
+                         OutputIterator result, Compare comp={},
+                         Projection1 proj1={}, Projection2 proj2={})
+    -> std::ranges::set_intersection_result<Iterator1, Iterator2, OutputIterator>
+{
+    auto last1_it = std::ranges::next(first1, last1);
+    auto last2_it = std::ranges::next(first2, last2);
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first1, last1_it, comp, proj1) && "Precondition");
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first2, last2_it, comp, proj2) && "Precondition");
+    detail::gallopWalk<timsort_traits<std::iter_value_t<Iterator1>>>(
+        first1, last1_it, first2, last2_it, comp, proj1, proj2,
+        [](Iterator1, std::iter_difference_t<Iterator1>) {},
+        [](Iterator2, std::iter_difference_t<Iterator2>) {},
+        [&result](Iterator1& it1, Iterator2& it2) {
+            *result = *it1;
+            ++result;
+            ++it1;
+            ++it2;
+        }
+    );
+    return { std::move(last1_it), std::move(last2_it), std::move(result) };
+}
+
+/**
+ * Computes the sorted intersection of two sorted ranges with a comparison function and
+ * projection functions, galloping over the chunks of elements found in only one of them.
+ */
+template <
+    std::ranges::random_access_range Range1,
+    std::ranges::random_access_range Range2,
+    std::weakly_incrementable OutputIterator,
+    typename Compare = std::ranges::less,
+    typename Projection1 = std::identity,
+    typename Projection2 = std::identity
+>
+    requires std::mergeable<
+        std::ranges::iterator_t<Range1>,
+        std::ranges::iterator_t<Range2>,
+        OutputIterator, Compare, Projection1, Projection2
+    >
+auto timset_intersection(Range1 &&range1, Range2 &&range2, OutputIterator result,
+                         Compare comp={}, Projection1 proj1={}, Projection2 proj2={})
+    -> std::ranges::set_intersection_result<
+        std::ranges::borrowed_iterator_t<Range1>,
+        std::ranges::borrowed_iterator_t<Range2>,
+        OutputIterator
+    >
+{
+    return gfx::timset_intersection(std::begin(range1), std::end(range1),
+                                     std::begin(range2), std::end(range2),
+                                     std::move(result), comp, proj1, proj2);
+}
+
+/**
+ * Computes the sorted difference of two sorted ranges with a comparison function and
+ * projection functions, galloping over the chunks of elements found in only one of them.
+ */
+template <
+    std::random_access_iterator Iterator1,
+    std::sentinel_for<Iterator1> Sentinel1,
+    std::random_access_iterator Iterator2,
+    std::sentinel_for<Iterator2> Sentinel2,
+    std::weakly_incrementable OutputIterator,
+    typename Compare = std::ranges::less,
+    typename Projection1 = std::identity,
+    typename Projection2 = std::identity
+>
+    requires std::mergeable<Iterator1, Iterator2, OutputIterator, Compare, Projection1, Projection2>
+auto timset_difference(Iterator1 first1, Sentinel1 last1, Iterator2 first2, Sentinel2 last2,
+                       OutputIterator result, Compare comp={},
+                       Projection1 proj1={}, Projection2 proj2={})
+    -> std::ranges::set_difference_result<Iterator1, OutputIterator>
+{
+    auto last1_it = std::ranges::next(first1, last1);
+    auto last2_it = std::ranges::next(first2, last2);
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first1, last1_it, comp, proj1) && "Precondition");
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first2, last2_it, comp, proj2) && "Precondition");
+    detail::gallopWalk<timsort_traits<std::iter_value_t<Iterator1>>>(
+        first1, last1_it, first2, last2_it, comp, proj1, proj2,
+        [&result](Iterator1 it, std::iter_difference_t<Iterator1> count) {
+            result = std::ranges::copy_n(it, count, std::move(result)).out;
+        },
+        [](Iterator2, std::iter_difference_t<Iterator2>) {},
+        [](Iterator1& it1, Iterator2& it2) {
+            ++it1;
+            ++it2;
+        }
+    );
+    auto [in1, out1] = std::ranges::copy(std::move(first1), std::move(last1_it),
+                                         std::move(result));
+    return { std::move(in1), std::move(out1) };
+}
+
+/**
+ * Computes the sorted difference of two sorted ranges with a comparison function and
+ * projection functions, galloping over the chunks of elements found in only one of them.
+ */
+template <
+    std::ranges::random_access_range Range1,
+    std::ranges::random_access_range Range2,
+    std::weakly_incrementable OutputIterator,
+    typename Compare = std::ranges::less,
+    typename Projection1 = std::identity,
+    typename Projection2 = std::identity
+>
+    requires std::mergeable<
+        std::ranges::iterator_t<Range1>,
+        std::ranges::iterator_t<Range2>,
+        OutputIterator, Compare, Projection1, Projection2
+    >
+auto timset_difference(Range1 &&range1, Range2 &&range2, OutputIterator result,
+                       Compare comp={}, Projection1 proj1={}, Projection2 proj2={})
+    -> std::ranges::set_difference_result<std::ranges::borrowed_iterator_t<Range1>, OutputIterator>
+{
+    return gfx::timset_difference(std::begin(range1), std::end(range1),
+                                   std::begin(range2), std::end(range2),
+                                   std::move(result), comp, proj1, proj2);
+}
+
+/**
+ * Computes the sorted symmetric difference of two sorted ranges with a comparison function
+ * and projection functions, galloping over the chunks of elements found in only one of them.
+ */
+template <
+    std::random_access_iterator Iterator1,
+    std::sentinel_for<Iterator1> Sentinel1,
+    std::random_access_iterator Iterator2,
+    std::sentinel_for<Iterator2> Sentinel2,
+    std::weakly_incrementable OutputIterator,
+    typename Compare = std::ranges::less,
+    typename Projection1 = std::identity,
+    typename Projection2 = std::identity
+>
+    requires std::mergeable<Iterator1, Iterator2, OutputIterator, Compare, Projection1, Projection2>
+auto timset_symmetric_difference(Iterator1 first1, Sentinel1 last1,
+                                 Iterator2 first2, Sentinel2 last2,
+                                 OutputIterator result, Compare comp={},
+                                 Projection1 proj1={}, Projection2 proj2={})
+    -> std::ranges::set_symmetric_difference_result<Iterator1, Iterator2, OutputIterator>
+{
+    auto last1_it = std::ranges::next(first1, last1);
+    auto last2_it = std::ranges::next(first2, last2);
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first1, last1_it, comp, proj1) && "Precondition");
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first2, last2_it, comp, proj2) && "Precondition");
+    detail::gallopWalk<timsort_traits<std::iter_value_t<Iterator1>>>(
+        first1, last1_it, first2, last2_it, comp, proj1, proj2,
+        [&result](Iterator1 it, std::iter_difference_t<Iterator1> count) {
+            result = std::ranges::copy_n(it, count, std::move(result)).out;
+        },
+        [&result](Iterator2 it, std::iter_difference_t<Iterator2> count) {
+            result = std::ranges::copy_n(it, count, std::move(result)).out;
+        },
+        [](Iterator1& it1, Iterator2& it2) {
+            ++it1;
+            ++it2;
+        }
+    );
+    auto [in1, out1] = std::ranges::copy(std::move(first1), std::move(last1_it),
+                                         std::move(result));
+    auto [in2, out2] = std::ranges::copy(std::move(first2), std::move(last2_it),
+                                         std::move(out1));
+    return { std::move(in1), std::move(in2), std::move(out2) };
+}
+
+/**
+ * Computes the sorted symmetric difference of two sorted ranges with a comparison function
+ * and projection functions, galloping over the chunks of elements found in only one of them.
+ */
+template <
+    std::ranges::random_access_range Range1,
+    std::ranges::random_access_range Range2,
+    std::weakly_incrementable OutputIterator,
+    typename Compare = std::ranges::less,
+    typename Projection1 = std::identity,
+    typename Projection2 = std::identity
+>
+    requires std::mergeable<
+        std::ranges::iterator_t<Range1>,
+        std::ranges::iterator_t<Range2>,
+        OutputIterator, Compare, Projection1, Projection2
+    >
+auto timset_symmetric_difference(Range1 &&range1, Range2 &&range2, OutputIterator result,
+                                 Compare comp={}, Projection1 proj1={}, Projection2 proj2={})
+    -> std::ranges::set_symmetric_difference_result<
+        std::ranges::borrowed_iterator_t<Range1>,
+        std::ranges::borrowed_iterator_t<Range2>,
+        OutputIterator
+    >
+{
+    return gfx::timset_symmetric_difference(std::begin(range1), std::end(range1),
+                                             std::begin(range2), std::end(range2),
+                                             std::move(result), comp, proj1, proj2);
+}
+
+/**
+ * Calls fun(elem1, elem2) for every pair of equivalent elements of two sorted ranges, in
+ * order, using galloping to skip the elements without a match. Returns fun.
+ */
+template <
+    std::random_access_iterator Iterator1,
+    std::sentinel_for<Iterator1> Sentinel1,
+    std::random_access_iterator Iterator2,
+    std::sentinel_for<Iterator2> Sentinel2,
+    typename Function,
+    typename Compare = std::ranges::less,
+    typename Projection1 = std::identity,
+    typename Projection2 = std::identity
+>
+    requires std::indirect_strict_weak_order<
+        Compare,
+        std::projected<Iterator1, Projection1>,
+        std::projected<Iterator2, Projection2>
+    > && std::invocable<Function&, std::iter_reference_t<Iterator1>,
+                                   std::iter_reference_t<Iterator2>>
+auto merge_join(Iterator1 first1, Sentinel1 last1, Iterator2 first2, Sentinel2 last2,
+                Function fun, Compare comp={},
+                Projection1 proj1={}, Projection2 proj2={})
+    -> Function
+{
+    auto last1_it = std::ranges::next(first1, last1);
+    auto last2_it = std::ranges::next(first2, last2);
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first1, last1_it, comp, proj1) && "Precondition");
+    GFX_TIMSORT_AUDIT(std::ranges::is_sorted(first2, last2_it, comp, proj2) && "Precondition");
+    detail::gallopWalk<timsort_traits<std::iter_value_t<Iterator1>>>(
+        first1, last1_it, first2, last2_it, comp, proj1, proj2,
+        [](Iterator1, std::iter_difference_t<Iterator1>) {},
+        [](Iterator2, std::iter_difference_t<Iterator2>) {},
+        [&](Iterator1& it1, Iterator2& it2) {
+            // Find the groups of elements equivalent to *it1 in both ranges
+            auto&& key = std::invoke(proj1, *it1);
+            auto const count1 = detail::gallopRight(key, it1, last1_it - it1, 0, comp, proj1);
+            auto const count2 = detail::gallopRight(key, it2, last2_it - it2, 0, comp, proj2);
+            auto const group1_end = it1 + count1;
+            auto const group2_end = it2 + count2;
+            for (; it1 != group1_end; ++it1) {
+                for (auto it = it2; it != group2_end; ++it) {
+                    std::invoke(fun, *it1, *it);
+                }
+            }
+            it2 = group2_end;
+        }
+    );
+    return fun;
+}
+
+/**
+ * Calls fun(elem1, elem2) for every pair of equivalent elements of two sorted ranges, in
+ * order, using galloping to skip the elements without a match. Returns fun.
+ */
+template <
+    std::ranges::random_access_range Range1,
+    std::ranges::random_access_range Range2,
+    typename Function,
+    typename Compare = std::ranges::less,
+    typename Projection1 = std::identity,
+    typename Projection2 = std::identity
+>
+    requires std::indirect_strict_weak_order<
+        Compare,
+        std::projected<std::ranges::iterator_t<Range1>, Projection1>,
+        std::projected<std::ranges::iterator_t<Range2>, Projection2>
+    > && std::invocable<Function&, std::ranges::range_reference_t<Range1>,
+                                   std::ranges::range_reference_t<Range2>>
+auto merge_join(Range1 &&range1, Range2 &&range2, Function fun, Compare comp={},
+                Projection1 proj1={}, Projection2 proj2={})
+    -> Function
 {
-    return gfx::timsort(std::begin(range), std::end(range), comp, proj);
+    return gfx::merge_join(std::begin(range1), std::end(range1),
+                           std::begin(range2), std::end(range2),
+                           std::move(fun), comp, proj1, proj2);
 }
 
 } // namespace gfx
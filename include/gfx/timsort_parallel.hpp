@@ -0,0 +1,816 @@
+/*
+ * Parallel overloads of the algorithms of gfx::timsort, run by executors
+ *
+ * Copyright (c) 2024 Morwenn.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef GFX_TIMSORT_PARALLEL_HPP
+#define GFX_TIMSORT_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <gfx/timsort.hpp>
+
+namespace gfx {
+
+// ---------------------------------------
+// Executors
+// ---------------------------------------
+
+/**
+ * Executors run the tasks of the parallel overloads of the algorithms: submit(task) calls
+ * task(), a callable object taking no parameters that doesn't throw, once on any thread. The
+ * tasks never block waiting for each other: the task that finishes the last of a group of
+ * tasks runs what comes after them. try_run_one() runs one of the tasks submitted to the
+ * executor on the calling thread and returns whether there was one: the thread that called
+ * an algorithm runs tasks until all of its tasks have ended, so that calling an algorithm
+ * from a task of a busy executor never waits for threads that are all taken. When the
+ * executor has a member function concurrency(), the work is split according to the number
+ * of threads it returns.
+ */
+template <typename Executor>
+concept timsort_executor = requires (Executor& executor, std::function<void()> task) {
+    executor.submit(std::move(task));
+    { executor.try_run_one() } -> std::convertible_to<bool>;
+};
+
+/**
+ * Thread pool satisfying timsort_executor: every worker thread has its own queue of tasks,
+ * where it pushes the tasks it submits and takes them back in reverse order. Idle workers
+ * steal the oldest tasks from the queues of the others, or take tasks submitted from other
+ * threads. Threads waiting for an algorithm to end run tasks too. Destroying the pool waits
+ * for the tasks submitted to it to end.
+ */
+class work_stealing_pool {
+    struct task_queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // One queue per worker, then the queue of the tasks submitted from other threads
+    std::vector<std::unique_ptr<task_queue>> queues_;
+    std::atomic<std::size_t> queued_ = 0;
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+    std::vector<std::jthread> workers_;
+
+    // Pool and queue of the worker running on the current thread, if any
+    static inline thread_local work_stealing_pool* currentPool_ = nullptr;
+    static inline thread_local std::size_t currentQueue_ = 0;
+
+    std::size_t ownQueue() const {
+        return currentPool_ == this ? currentQueue_ : queues_.size() - 1;
+    }
+
+    // Takes a task from the back of the own queue of the current thread, else from the
+    // front of the other queues
+    bool take(std::function<void()>& task) {
+        auto const own = ownQueue();
+        for (std::size_t i = 0; i < queues_.size(); ++i) {
+            auto const index = (own + i) % queues_.size();
+            auto& queue = *queues_[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                if (index == own) {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                } else {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+                queued_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(std::size_t const index) {
+        currentPool_ = this;
+        currentQueue_ = index;
+        std::function<void()> task;
+        while (true) {
+            if (take(task)) {
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            wake_.wait(lock, [this] {
+                return stop_ || queued_.load(std::memory_order_relaxed) != 0;
+            });
+            if (stop_ && queued_.load(std::memory_order_relaxed) == 0) {
+                return;
+            }
+        }
+    }
+
+public:
+    /**
+     * Starts the given number of worker threads, as many as the hardware runs concurrently
+     * minus one for the thread waiting for the algorithms by default.
+     */
+    explicit work_stealing_pool(std::size_t threads =
+                                    (std::max)(std::thread::hardware_concurrency(), 2u) - 1) {
+        for (std::size_t i = 0; i <= threads; ++i) {
+            queues_.push_back(std::make_unique<task_queue>());
+        }
+        workers_.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    work_stealing_pool(work_stealing_pool const&) = delete;
+    work_stealing_pool& operator=(work_stealing_pool const&) = delete;
+
+    ~work_stealing_pool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        workers_.clear();
+        // Without workers, the tasks left are run by the thread destroying the pool
+        std::function<void()> task;
+        while (take(task)) {
+            task();
+        }
+    }
+
+    void submit(std::function<void()> task) {
+        {
+            // Counted before being published, so that the thread taking the task never
+            // decrements the count first, and under the lock of the sleeping workers, so
+            // that none misses the wake-up
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            queued_.fetch_add(1, std::memory_order_relaxed);
+        }
+        try {
+            auto& queue = *queues_[ownQueue()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        } catch (...) {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            throw;
+        }
+        wake_.notify_one();
+    }
+
+    bool try_run_one() {
+        std::function<void()> task;
+        if (!take(task)) {
+            return false;
+        }
+        task();
+        return true;
+    }
+
+    /**
+     * Number of threads running tasks: the workers and a thread waiting for an algorithm.
+     */
+    std::size_t concurrency() const noexcept {
+        return queues_.size();
+    }
+};
+
+// ---------------------------------------
+// Implementation details
+// ---------------------------------------
+
+namespace detail {
+
+// Sorting objects shared by the tasks sorting the chunks of a batch in parallel: a task
+// takes one for its chunk, creating it if there is none left, and gives it back afterwards,
+// so that there are never more of them than of tasks running at the same time, and each
+// one keeps the temporary storage of the biggest merge it ran and the buffer of the biggest
+// range it gathered for the next chunks
+template <typename Sort>
+class batch_workspaces {
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Sort>> free_;
+
+public:
+    template <typename Function>
+    void use(Function fn) {
+        std::unique_ptr<Sort> ts;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                ts = std::move(free_.back());
+                free_.pop_back();
+            }
+        }
+        fn(ts);
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(std::move(ts));
+    }
+};
+
+// Number of threads an executor runs its tasks on
+template <typename Executor>
+std::size_t executorConcurrency(Executor& executor) {
+    if constexpr (requires { { executor.concurrency() } -> std::convertible_to<std::size_t>; }) {
+        return (std::max)(static_cast<std::size_t>(executor.concurrency()), std::size_t(1));
+    } else {
+        return (std::max)(std::thread::hardware_concurrency(), 1u);
+    }
+}
+
+// Number of workers of the pool used by the overloads taking a number of threads, the
+// thread waiting for the algorithm being one of them
+inline std::size_t poolWorkers(std::size_t const threads) {
+    if (threads == 0) {
+        return (std::max)(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+    return threads - 1;
+}
+
+// Tasks of a parallel algorithm run by an executor: the thread that started the algorithm
+// runs tasks of the executor until all of them have ended, never blocking on them. The
+// first exception thrown by a task is rethrown to that thread, and the tasks that didn't
+// start yet by then do nothing.
+template <typename Executor>
+class parallel_job {
+    Executor& executor_;
+    std::atomic<std::size_t> pending_ = 0;
+    std::atomic<bool> failed_ = false;
+    std::exception_ptr error_;
+    std::mutex mutex_;
+    std::condition_variable changed_; // notified when a task is submitted or the job ends
+    std::size_t submitted_ = 0;
+    bool finished_ = false;
+
+    void fail(std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_) {
+            error_ = std::move(error);
+        }
+        failed_.store(true, std::memory_order_relaxed);
+    }
+
+    template <typename Function>
+    void run(Function& fn) {
+        if (failed()) {
+            return;
+        }
+        try {
+            fn();
+        } catch (...) {
+            fail(std::current_exception());
+        }
+    }
+
+    void finish() {
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // Notified under the lock, so that the waiting thread can't destroy the job
+            // before the notification is over
+            std::lock_guard<std::mutex> lock(mutex_);
+            finished_ = true;
+            changed_.notify_all();
+        }
+    }
+
+    // Wakes the waiting thread up to run the task just submitted
+    void submitted() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++submitted_;
+        changed_.notify_all();
+    }
+
+public:
+    explicit parallel_job(Executor& executor) : executor_(executor) {
+    }
+
+    bool failed() const {
+        return failed_.load(std::memory_order_relaxed);
+    }
+
+    // Runs fn on the current thread as a task of the job
+    template <typename Function>
+    void runHere(Function fn) {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        run(fn);
+        finish();
+    }
+
+    // Submits fn to the executor as a task of the job
+    template <typename Function>
+    void spawn(Function fn) {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        try {
+            executor_.submit([this, fn = std::move(fn)]() mutable {
+                run(fn);
+                finish();
+            });
+        } catch (...) {
+            fail(std::current_exception());
+            finish();
+            return;
+        }
+        submitted();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!finished_) {
+            // Tasks submitted after this point wake the thread up if it finds none to run
+            auto const seen = submitted_;
+            lock.unlock();
+            bool const ran = executor_.try_run_one();
+            lock.lock();
+            if (!ran) {
+                // The tasks left run on other threads, but they may submit more
+                changed_.wait(lock, [this, seen] { return finished_ || submitted_ != seen; });
+            }
+        }
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+};
+
+// Calls fn(begin, end) for consecutive chunks of [0, count) in tasks of a job, several chunks
+// per thread of the executor on average so that the threads done with cheap chunks take over
+// the remaining ones
+template <typename Executor, typename Function>
+void forEachChunk(Executor& executor, std::size_t const count, Function fn) {
+    constexpr std::size_t chunksPerThread = 8;
+    auto const chunk = (std::max)(count / (chunksPerThread * executorConcurrency(executor)),
+                                  std::size_t(1));
+
+    parallel_job<Executor> job(executor);
+    job.runHere([&] {
+        for (std::size_t begin = 0; begin < count; begin += chunk) {
+            auto const end = (std::min)(count, begin + chunk);
+            job.spawn([&fn, begin, end] { fn(begin, end); });
+        }
+    });
+    job.wait();
+}
+
+// Parallel TimSort: chunks of the range are scanned for runs in parallel, the short runs
+// being extended to the minimum run length, then the runs are merged along the tree that
+// the stack of pending runs of TimSort would follow. No task ever waits for another: the
+// last chunk scanned builds the merge tree, and the last of the two merges feeding a merge
+// runs it, calling the continuation of the sort once the root is merged. Big merges are
+// split in two independent merges by cutting both ranges around an element of the bigger
+// one and rotating the middle parts, then run in parallel too.
+template <typename Iterator, typename Policy, typename Executor, typename Compare,
+          typename Projection>
+class ParallelTimSort {
+    using diff_t = std::iter_difference_t<Iterator>;
+    using continuation = std::function<void()>;
+    using sort_t = TimSort<Iterator, void, Policy>;
+
+    // Merge of [lo, mid) and [mid, hi) waiting for the merges producing its runs, if any
+    struct merge_node {
+        Iterator lo;
+        Iterator mid;
+        Iterator hi;
+        std::ptrdiff_t parent = -1;
+        std::atomic<int> pending = 0;
+    };
+
+    // Runs found by the scans of the chunks, then the merge tree built over them
+    struct merge_tree {
+        std::vector<std::vector<run<Iterator>>> chunkRuns;
+        std::vector<merge_node> nodes;
+        continuation then;
+    };
+
+    parallel_job<Executor>& job_;
+    Compare comp_;
+    Projection proj_;
+    diff_t grain_;
+
+    // Continuation calling then once it has been called count times
+    static continuation join(continuation then, int count = 2) {
+        auto pending = std::make_shared<std::atomic<int>>(count);
+        return [pending, then = std::move(then)] {
+            if (pending->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                then();
+            }
+        };
+    }
+
+    // Replays the merges of the stack of pending runs of TimSort over the runs found: the
+    // nodes are created children first, so the last one is the root
+    static void buildTree(merge_tree& tree) {
+        std::size_t count = 0;
+        for (auto const& runs : tree.chunkRuns) {
+            count += runs.size();
+        }
+        tree.nodes = std::vector<merge_node>(count - 1);
+
+        run_stack<Iterator> pending;
+        std::vector<std::ptrdiff_t> pendingNodes; // -1 for runs that aren't merged yet
+        std::size_t created = 0;
+        auto mergeAt = [&](std::size_t const i) {
+            auto const [run1, run2] = pending.joinAt(i);
+            auto const index = static_cast<std::ptrdiff_t>(created++);
+            auto& node = tree.nodes[static_cast<std::size_t>(index)];
+            node.lo = run1.base;
+            node.mid = run2.base;
+            node.hi = run2.base + run2.len;
+            for (auto const child : { pendingNodes[i], pendingNodes[i + 1] }) {
+                if (child != -1) {
+                    tree.nodes[static_cast<std::size_t>(child)].parent = index;
+                    node.pending.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            pendingNodes[i] = index;
+            pendingNodes.erase(pendingNodes.begin() + static_cast<std::ptrdiff_t>(i) + 1);
+        };
+
+        for (auto const& runs : tree.chunkRuns) {
+            for (auto const& r : runs) {
+                pending.emplace_back(r.base, r.len);
+                pendingNodes.push_back(-1);
+                pending.collapse(mergeAt);
+            }
+        }
+        pending.forceCollapse(mergeAt);
+    }
+
+    // Merges a node of the tree, then its parent if it was the last merge the parent waited
+    // for, or calls the continuation of the sort after the root
+    void mergeNode(std::shared_ptr<merge_tree> const& tree, std::size_t const index) {
+        auto& node = tree->nodes[index];
+        merge(node.lo, node.mid, node.hi, [this, tree, index] {
+            auto const parent = tree->nodes[index].parent;
+            if (parent == -1) {
+                tree->then();
+                return;
+            }
+            auto& parentNode = tree->nodes[static_cast<std::size_t>(parent)];
+            if (parentNode.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                mergeNode(tree, static_cast<std::size_t>(parent));
+            }
+        });
+    }
+
+    // Starts the merges of two runs found by the scans, which wait for no other merge
+    void startMerges(std::shared_ptr<merge_tree> const& tree) {
+        buildTree(*tree);
+        if (tree->nodes.empty()) {
+            tree->then();
+            return;
+        }
+
+        std::vector<std::size_t> leaves;
+        for (std::size_t i = 0; i < tree->nodes.size(); ++i) {
+            if (tree->nodes[i].pending.load(std::memory_order_relaxed) == 0) {
+                leaves.push_back(i);
+            }
+        }
+        for (std::size_t i = 1; i < leaves.size(); ++i) {
+            job_.spawn([this, tree, index = leaves[i]] { mergeNode(tree, index); });
+        }
+        mergeNode(tree, leaves[0]);
+    }
+
+public:
+    // Below that size, sorting and merging aren't worth splitting
+    static constexpr diff_t MIN_GRAIN = 1 << 13;
+
+    ParallelTimSort(parallel_job<Executor>& job, Compare comp, Projection proj, diff_t grain) :
+        job_(job), comp_(std::move(comp)), proj_(std::move(proj)), grain_(grain) {
+    }
+
+    void sort(Iterator const lo, Iterator const hi, continuation then) {
+        if (job_.failed()) {
+            return;
+        }
+        if (hi - lo <= grain_) {
+            sort_t::sort(lo, hi, comp_, proj_);
+            then();
+            return;
+        }
+
+        // Chunks made of whole minimum runs, so that only the natural runs crossing their
+        // boundaries are cut, which the merges put back together by galloping
+        auto const minRun = policy_constants<Policy>::minRunLength(hi - lo);
+        auto const chunk = (std::max)(grain_ / minRun, diff_t(1)) * minRun;
+        auto const chunks = static_cast<std::size_t>((hi - lo + chunk - 1) / chunk);
+
+        auto tree = std::make_shared<merge_tree>();
+        tree->chunkRuns.resize(chunks);
+        tree->then = std::move(then);
+        auto const whenScanned = join([this, tree] { startMerges(tree); },
+                                      static_cast<int>(chunks));
+        auto scan = [this, lo, hi, chunk, minRun, tree, whenScanned](std::size_t const i) {
+            auto const chunkLo = lo + static_cast<diff_t>(i) * chunk;
+            auto const chunkHi = hi - chunkLo > chunk ? chunkLo + chunk : hi;
+            auto& runs = tree->chunkRuns[i];
+            sort_t::findRuns(chunkLo, chunkHi, minRun, comp_, proj_,
+                             [&runs](Iterator const base, diff_t const len) {
+                                 runs.emplace_back(base, len);
+                             });
+            whenScanned();
+        };
+        for (std::size_t i = 1; i < chunks; ++i) {
+            job_.spawn([scan, i] { scan(i); });
+        }
+        scan(0);
+    }
+
+    void merge(Iterator const lo, Iterator const mid, Iterator const hi, continuation then) {
+        if (job_.failed()) {
+            return;
+        }
+        if (hi - lo <= 2 * grain_ || lo == mid || mid == hi) {
+            sort_t::merge(lo, mid, hi, comp_, proj_);
+            then();
+            return;
+        }
+        if (!std::invoke(comp_, std::invoke(proj_, *mid),
+                         std::invoke(proj_, *std::ranges::prev(mid)))) {
+            // Runs already in order, such as a natural run cut by the chunks of the scan
+            then();
+            return;
+        }
+
+        // Every element of [lo, cut1) and [mid, cut2) precedes every element of [cut1, mid)
+        // and [cut2, hi) in the merged range, equal elements of the first range first
+        Iterator cut1;
+        Iterator cut2;
+        if (mid - lo >= hi - mid) {
+            cut1 = lo + (mid - lo) / 2;
+            cut2 = std::ranges::lower_bound(mid, hi, std::invoke(proj_, *cut1), comp_, proj_);
+        } else {
+            cut2 = mid + (hi - mid) / 2;
+            cut1 = std::ranges::upper_bound(lo, mid, std::invoke(proj_, *cut2), comp_, proj_);
+        }
+        auto const newMid = std::ranges::rotate(cut1, mid, cut2).begin();
+
+        auto const whenMerged = join(std::move(then));
+        job_.spawn([this, lo, cut1, newMid, whenMerged] { merge(lo, cut1, newMid, whenMerged); });
+        merge(newMid, cut2, hi, whenMerged);
+    }
+};
+
+// Sorts or merges [lo, hi) with the tasks of a parallel job, with about four chunks to scan
+// per thread of the executor
+template <typename Policy, typename Executor, typename Iterator, typename Compare,
+          typename Projection>
+void parallelSort(Executor& executor, Iterator const lo, Iterator const mid, Iterator const hi,
+                  bool const merge, Compare comp, Projection proj) {
+    using parallel_sort_t = ParallelTimSort<Iterator, Policy, Executor, Compare, Projection>;
+    using diff_t = std::iter_difference_t<Iterator>;
+
+    auto const threads = static_cast<diff_t>(executorConcurrency(executor));
+    auto const grain = (std::max)((hi - lo) / (4 * threads), parallel_sort_t::MIN_GRAIN);
+
+    parallel_job<Executor> job(executor);
+    parallel_sort_t sorter(job, std::move(comp), std::move(proj), grain);
+    job.runHere([&] {
+        if (merge) {
+            sorter.merge(lo, mid, hi, [] {});
+        } else {
+            sorter.sort(lo, hi, [] {});
+        }
+    });
+    job.wait();
+}
+
+} // namespace detail
+
+// ---------------------------------------
+// Public interface implementation
+// ---------------------------------------
+
+/**
+ * Stably merges two consecutive sorted ranges [first, middle) and [middle, last) into one
+ * sorted range [first, last) with a comparison function and a projection function, splitting
+ * big merges in independent merges run by the threads of an executor. The comparison and
+ * projection functions are called concurrently.
+ */
+template <
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    timsort_executor Executor,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<Iterator, Compare, Projection>
+auto timmerge(Iterator first, Iterator middle, Sentinel last, Executor &executor,
+              Compare comp={}, Projection proj={})
+    -> Iterator
+{
+    using policy_t = timsort_traits<std::iter_value_t<Iterator>>;
+
+    auto last_it = std::ranges::next(first, last);
+    detail::auditPrecondition([&] { return std::ranges::is_sorted(first, middle, comp, proj); });
+    detail::auditPrecondition([&] { return std::ranges::is_sorted(middle, last_it, comp, proj); });
+    detail::parallelSort<policy_t>(executor, first, middle, last_it, true, comp, proj);
+    detail::auditPostcondition([&] { return std::ranges::is_sorted(first, last_it, comp, proj); });
+    return last_it;
+}
+
+/**
+ * Stably merges two sorted halves [first, middle) and [middle, last) of a range into one
+ * sorted range [first, last) with a comparison function and a projection function, splitting
+ * big merges in independent merges run by the threads of an executor. The comparison and
+ * projection functions are called concurrently.
+ */
+template <
+    std::ranges::random_access_range Range,
+    timsort_executor Executor,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+auto timmerge(Range &&range, std::ranges::iterator_t<Range> middle, Executor &executor,
+              Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    return gfx::timmerge(std::begin(range), middle, std::end(range), executor, comp, proj);
+}
+
+/**
+ * Stably sorts a range with a comparison function and a projection function: parts of the
+ * range are sorted and merged in tasks run by the threads of an executor, big merges being
+ * split in independent merges. The comparison and projection functions are called
+ * concurrently.
+ */
+template <
+    std::random_access_iterator Iterator,
+    std::sentinel_for<Iterator> Sentinel,
+    timsort_executor Executor,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<Iterator, Compare, Projection>
+auto timsort(Iterator first, Sentinel last, Executor &executor,
+             Compare comp={}, Projection proj={})
+    -> Iterator
+{
+    using policy_t = timsort_traits<std::iter_value_t<Iterator>>;
+
+    auto last_it = std::ranges::next(first, last);
+    detail::parallelSort<policy_t>(executor, first, first, last_it, false, comp, proj);
+    detail::auditPostcondition([&] { return std::ranges::is_sorted(first, last_it, comp, proj); });
+    return last_it;
+}
+
+/**
+ * Stably sorts a range with a comparison function and a projection function: parts of the
+ * range are sorted and merged in tasks run by the threads of an executor, big merges being
+ * split in independent merges. The comparison and projection functions are called
+ * concurrently.
+ */
+template <
+    std::ranges::random_access_range Range,
+    timsort_executor Executor,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+auto timsort(Range &&range, Executor &executor, Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    return gfx::timsort(std::begin(range), std::end(range), executor, comp, proj);
+}
+
+/**
+ * Stably sorts every range of a batch of independent ranges with a comparison function and a
+ * projection function, spreading the sorts over the threads of an executor. The comparison
+ * and projection functions are called concurrently. The sorts running one after the other
+ * share their temporary storage, so there are at most as many allocations as of sorts
+ * running at the same time.
+ */
+template <
+    std::ranges::random_access_range Ranges,
+    timsort_executor Executor,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::ranges::random_access_range<std::ranges::range_reference_t<Ranges>>
+          && std::sortable<detail::batch_iterator_t<Ranges>, Compare, Projection>
+auto timsort_batch(Ranges &&ranges, Executor &executor, Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Ranges>
+{
+    using iter_t = detail::batch_iterator_t<Ranges>;
+    using policy_t = timsort_traits<std::iter_value_t<iter_t>>;
+    using sort_t = detail::TimSort<iter_t, void, policy_t>;
+
+    auto first = std::ranges::begin(ranges);
+    auto last = std::ranges::next(first, std::ranges::end(ranges));
+    auto const count = static_cast<std::size_t>(last - first);
+    detail::batch_workspaces<sort_t> workspaces;
+    detail::forEachChunk(executor, count, [&](std::size_t begin, std::size_t end) {
+        using diff_t = std::iter_difference_t<decltype(first)>;
+        sort_t::sortBatch(first + static_cast<diff_t>(begin), first + static_cast<diff_t>(end),
+                          comp, proj, workspaces);
+    });
+    detail::auditPostcondition([&] {
+        return std::ranges::all_of(first, last, [&](auto &&range) {
+            return std::ranges::is_sorted(range, comp, proj);
+        });
+    });
+    return last;
+}
+
+/**
+ * Stably sorts every range of a batch of independent ranges with a comparison function and a
+ * projection function, spreading the sorts over up to the given number of threads, or over as
+ * many threads as the hardware runs concurrently when it is 0. The comparison and projection
+ * functions are called concurrently.
+ */
+template <
+    std::ranges::random_access_range Ranges,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::ranges::random_access_range<std::ranges::range_reference_t<Ranges>>
+          && std::sortable<detail::batch_iterator_t<Ranges>, Compare, Projection>
+auto timsort_batch(Ranges &&ranges, std::size_t threads, Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Ranges>
+{
+    work_stealing_pool pool(detail::poolWorkers(threads));
+    return gfx::timsort_batch(std::forward<Ranges>(ranges), pool, comp, proj);
+}
+
+/**
+ * Stably sorts every segment of a range stored in CSR layout with a comparison function and a
+ * projection function, spreading the segments over the threads of an executor. The
+ * comparison and projection functions are called concurrently, and the temporary storage is
+ * shared like in timsort_batch.
+ */
+template <
+    std::ranges::random_access_range Range,
+    std::ranges::random_access_range Offsets,
+    timsort_executor Executor,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+          && std::integral<std::ranges::range_value_t<Offsets>>
+auto timsort_segmented(Range &&range, Offsets &&offsets, Executor &executor,
+                       Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    auto first = std::ranges::begin(range);
+    auto last = std::ranges::next(first, std::ranges::end(range));
+    gfx::timsort_batch(detail::segments(first, last, offsets), executor, comp, proj);
+    return last;
+}
+
+/**
+ * Stably sorts every segment of a range stored in CSR layout with a comparison function and a
+ * projection function, spreading the segments over up to the given number of threads, or
+ * over as many threads as the hardware runs concurrently when it is 0. The comparison and
+ * projection functions are called concurrently.
+ */
+template <
+    std::ranges::random_access_range Range,
+    std::ranges::random_access_range Offsets,
+    typename Compare = std::ranges::less,
+    typename Projection = std::identity
+>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+          && std::integral<std::ranges::range_value_t<Offsets>>
+auto timsort_segmented(Range &&range, Offsets &&offsets, std::size_t threads,
+                       Compare comp={}, Projection proj={})
+    -> std::ranges::borrowed_iterator_t<Range>
+{
+    work_stealing_pool pool(detail::poolWorkers(threads));
+    return gfx::timsort_segmented(std::forward<Range>(range), std::forward<Offsets>(offsets),
+                                  pool, comp, proj);
+}
+
+} // namespace gfx
+
+#endif // GFX_TIMSORT_PARALLEL_HPP
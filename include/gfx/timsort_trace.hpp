@@ -0,0 +1,130 @@
+/*
+ * Chrome trace event export for the hooks of gfx::timsort
+ *
+ * Copyright (c) 2024 Morwenn.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef GFX_TIMSORT_TRACE_HPP
+#define GFX_TIMSORT_TRACE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <ios>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gfx/timsort.hpp>
+
+namespace gfx {
+
+/**
+ * Hooks writing the phases of gfx::timsort and gfx::timmerge as complete events in the
+ * Chrome trace event format, which can be opened with chrome://tracing or Perfetto. The
+ * timestamps are relative to the creation of the sink, and the trace is closed when the
+ * sink is destroyed. A sink can be shared by several threads sorting concurrently.
+ * Constructing a sink from a file name throws std::ios_base::failure if the file can't
+ * be opened.
+ */
+class chrome_trace_sink {
+public:
+    explicit chrome_trace_sink(std::string const& filename) :
+        file_(filename),
+        out_(file_) {
+        if (!file_.is_open()) {
+            throw std::ios_base::failure("could not open " + filename);
+        }
+        out_ << "{\"traceEvents\":[";
+    }
+
+    explicit chrome_trace_sink(std::ostream& out) :
+        out_(out) {
+        out_ << "{\"traceEvents\":[";
+    }
+
+    chrome_trace_sink(chrome_trace_sink const&) = delete;
+    chrome_trace_sink& operator=(chrome_trace_sink const&) = delete;
+
+    ~chrome_trace_sink() {
+        out_ << "\n]}\n";
+        out_.flush();
+    }
+
+    void on_run(timsort_event const& event) {
+        write("run", event);
+    }
+
+    void on_binary_sort(timsort_event const& event) {
+        write("binary_sort", event);
+    }
+
+    void on_merge(timsort_event const& event) {
+        write("merge", event);
+    }
+
+    void on_gallop(timsort_event const& event) {
+        write("gallop", event);
+    }
+
+private:
+    void write(char const* name, timsort_event const& event) {
+        using microseconds = std::chrono::duration<double, std::micro>;
+        auto const ts = microseconds(event.start - origin_).count();
+        auto const dur = microseconds(event.end - event.start).count();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        out_ << (empty_ ? "\n" : ",\n")
+             << "{\"name\":\"" << name << "\",\"cat\":\"timsort\",\"ph\":\"X\""
+             << ",\"ts\":" << std::to_string(ts) << ",\"dur\":" << std::to_string(dur)
+             << ",\"pid\":1,\"tid\":" << threadIndex()
+             << ",\"args\":{\"offset\":" << event.offset << ",\"length\":" << event.length;
+        if (event.kind == timsort_event_kind::merge) {
+            out_ << ",\"length2\":" << event.length2;
+        }
+        out_ << ",\"stack_depth\":" << event.stack_depth << "}}";
+        empty_ = false;
+    }
+
+    // Small thread identifiers in order of appearance, more readable than hashes
+    std::size_t threadIndex() {
+        auto const id = std::this_thread::get_id();
+        for (std::size_t i = 0; i < threads_.size(); ++i) {
+            if (threads_[i] == id) {
+                return i;
+            }
+        }
+        threads_.push_back(id);
+        return threads_.size() - 1;
+    }
+
+    std::ofstream file_;
+    std::ostream& out_;
+    std::mutex mutex_;
+    std::vector<std::thread::id> threads_;
+    std::chrono::steady_clock::time_point origin_ = std::chrono::steady_clock::now();
+    bool empty_ = true;
+};
+
+} // namespace gfx
+
+#endif // GFX_TIMSORT_TRACE_HPP
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include "test_helpers.hpp"
+
+namespace
+{
+    struct record {
+        std::string name;
+        int id;
+
+        friend bool operator==(record const&, record const&) = default;
+    };
+
+    std::vector<record> make_records(int size) {
+        std::vector<record> res;
+        auto const numbers = test_helpers::duplicated_values(size, 613);
+        for (int i = 0; i < size; ++i) {
+            // Some names only differ after their first eight characters
+            auto name = std::to_string(numbers[static_cast<std::size_t>(i)]);
+            res.push_back({ (i % 2 == 0 ? "customer-" : "c") + name, i });
+        }
+        test_helpers::shuffle(res);
+        return res;
+    }
+
+    template<typename Range, typename Compare>
+    concept abbreviated_sortable = requires (Range& range, Compare comp) {
+        gfx::timsort_abbreviated(range, comp);
+    };
+}
+
+TEST_CASE( "abbreviate" ) {
+    gfx::abbreviate abbrev;
+
+    SECTION( "integers" ) {
+        CHECK(abbrev(-5) < abbrev(0));
+        CHECK(abbrev(0) < abbrev(3));
+        CHECK(abbrev(INT64_MIN) == 0);
+        CHECK(abbrev(INT64_MAX) == UINT64_MAX);
+        CHECK(abbrev(std::uint8_t(200)) > abbrev(std::uint8_t(100)));
+    }
+
+#ifdef __SIZEOF_INT128__
+    SECTION( "integers wider than the abbreviations" ) {
+        __extension__ typedef __int128 int128_t;
+        STATIC_REQUIRE(not std::invocable<gfx::abbreviate, int128_t>);
+        STATIC_REQUIRE(not abbreviated_sortable<std::vector<int128_t>, std::ranges::less>);
+    }
+#endif
+
+    SECTION( "strings" ) {
+        using namespace std::string_view_literals;
+        CHECK(abbrev("abc"sv) < abbrev("abd"sv));
+        CHECK(abbrev("ab"sv) < abbrev("abc"sv));
+        CHECK(abbrev(""sv) == 0);
+        CHECK(abbrev("\xff"sv) > abbrev("z"sv));
+        CHECK(abbrev("abcdefgh1"sv) == abbrev(std::string("abcdefgh2")));
+    }
+
+    SECTION( "floating-point values" ) {
+        CHECK(abbrev(-1.5) < abbrev(-0.5));
+        CHECK(abbrev(-0.5) < abbrev(-0.0));
+        CHECK(abbrev(-0.0) == abbrev(0.0));
+        CHECK(abbrev(0.0f) < abbrev(0.5f));
+    }
+}
+
+TEST_CASE( "timsort_abbreviated" ) {
+    for (int size : { 0, 1, 10, 100, 1000, 5000 }) {
+        auto vec = make_records(size);
+        auto expected = vec;
+        std::ranges::stable_sort(expected, {}, &record::name);
+
+        std::size_t full_comparisons = 0;
+        auto counted_less = [&](std::string const& lhs, std::string const& rhs) {
+            ++full_comparisons;
+            return lhs < rhs;
+        };
+        auto last_it = gfx::timsort_abbreviated(vec, counted_less, &record::name,
+                                                gfx::abbreviate{});
+        CHECK(last_it == vec.end());
+        CHECK(vec == expected);
+
+        // Sorting the same elements with the full comparison for reference
+        std::size_t reference_comparisons = 0;
+        auto reference_less = [&](std::string const& lhs, std::string const& rhs) {
+            ++reference_comparisons;
+            return lhs < rhs;
+        };
+        test_helpers::shuffle(vec);
+        gfx::timsort(vec, reference_less, &record::name);
+        CHECK(full_comparisons <= reference_comparisons);
+    }
+
+    SECTION( "stability of integer keys" ) {
+        std::vector<std::pair<int, int>> vec;
+        for (int i = 0; i < 2000; ++i) {
+            vec.emplace_back((i * 31) % 97 - 48, i);
+        }
+        test_helpers::shuffle(vec);
+        auto expected = vec;
+        std::ranges::stable_sort(expected, {}, &std::pair<int, int>::first);
+
+        std::deque<std::pair<int, int>> deq(vec.begin(), vec.end());
+        gfx::timsort_abbreviated(deq.begin(), deq.end(), {}, &std::pair<int, int>::first);
+        CHECK(std::ranges::equal(deq, expected));
+    }
+
+    SECTION( "stability of signed zeros" ) {
+        // -0.0 and +0.0 are equivalent, their relative order has to be kept
+        std::vector<std::pair<double, int>> vec;
+        for (int i = 0; i < 1000; ++i) {
+            vec.emplace_back(i % 3 == 0 ? 0.0 : (i % 3 == 1 ? -0.0 : double(i % 7) - 3.0), i);
+        }
+        test_helpers::shuffle(vec);
+        auto expected = vec;
+        std::ranges::stable_sort(expected, {}, &std::pair<double, int>::first);
+
+        gfx::timsort_abbreviated(vec, {}, &std::pair<double, int>::first);
+        CHECK(std::ranges::equal(vec, expected, {}, &std::pair<double, int>::second,
+                                 &std::pair<double, int>::second));
+    }
+
+    SECTION( "custom abbreviation" ) {
+        auto vec = make_records(1000);
+        auto expected = vec;
+        std::ranges::stable_sort(expected, std::ranges::greater{}, &record::id);
+
+        // Coarse abbreviation consistent with a descending order
+        auto abbrev = [](int id) { return std::uint64_t(1000 - id) / 64; };
+        gfx::timsort_abbreviated(vec, std::ranges::greater{}, &record::id, abbrev);
+        CHECK(vec == expected);
+    }
+
+    SECTION( "descending comparison" ) {
+        // gfx::abbreviate is only the default for ascending comparisons
+        STATIC_REQUIRE(abbreviated_sortable<std::vector<std::string>, std::ranges::less>);
+        STATIC_REQUIRE(abbreviated_sortable<std::vector<std::string>, std::less<std::string>>);
+        STATIC_REQUIRE(not abbreviated_sortable<std::vector<std::string>, std::ranges::greater>);
+        STATIC_REQUIRE(not abbreviated_sortable<std::vector<std::string>, std::greater<>>);
+
+        auto vec = make_records(1000);
+        auto expected = vec;
+        std::ranges::stable_sort(expected, std::ranges::greater{}, &record::name);
+
+        auto abbrev = [](std::string const& name) { return ~gfx::abbreviate{}(name); };
+        gfx::timsort_abbreviated(vec, std::ranges::greater{}, &record::name, abbrev);
+        CHECK(vec == expected);
+    }
+}
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <list>
+#include <new>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include "test_helpers.hpp"
+
+// This file replaces the global allocation functions, so it lives in its own executable
+
+namespace
+{
+    std::atomic<std::size_t> allocations(0);
+
+    struct no_merge_buffer_policy : gfx::timsort_default_policy {
+        static constexpr std::size_t merge_buffer_bytes = 0;
+    };
+
+    // Number of allocations made by fun
+    template <typename Function>
+    std::size_t count_allocations(Function fun) {
+        auto before = allocations.load();
+        fun();
+        return allocations.load() - before;
+    }
+
+    void* allocate(std::size_t size) noexcept {
+        ++allocations;
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    // Over-aligned blocks store the pointer returned by malloc just before them, which
+    // keeps working where std::aligned_alloc isn't available
+    void* allocate(std::size_t size, std::align_val_t alignment) noexcept {
+        ++allocations;
+        auto const align = static_cast<std::size_t>(alignment);
+        void* base = std::malloc(size + align + sizeof(void*));
+        if (base == nullptr) {
+            return nullptr;
+        }
+        auto const address = reinterpret_cast<std::uintptr_t>(base) + sizeof(void*);
+        void* ptr = reinterpret_cast<void*>((address + align - 1) / align * align);
+        static_cast<void**>(ptr)[-1] = base;
+        return ptr;
+    }
+
+    void deallocate(void* ptr, std::align_val_t) noexcept {
+        if (ptr != nullptr) {
+            std::free(static_cast<void**>(ptr)[-1]);
+        }
+    }
+
+    void* allocate_or_throw(void* ptr) {
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+}
+
+void* operator new(std::size_t size) {
+    return allocate_or_throw(allocate(size));
+}
+
+void* operator new[](std::size_t size) {
+    return allocate_or_throw(allocate(size));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(allocate(size, alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(allocate(size, alignment));
+}
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept {
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept {
+    return allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept {
+    return allocate(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t alignment) noexcept {
+    deallocate(ptr, alignment);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept {
+    deallocate(ptr, alignment);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+    deallocate(ptr, alignment);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+    deallocate(ptr, alignment);
+}
+
+void operator delete(void* ptr, std::nothrow_t const&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::nothrow_t const&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t alignment, std::nothrow_t const&) noexcept {
+    deallocate(ptr, alignment);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment, std::nothrow_t const&) noexcept {
+    deallocate(ptr, alignment);
+}
+
+TEST_CASE( "small sorts and merges don't allocate" ) {
+    SECTION( "sort of small ranges" ) {
+        for (int size : { 10, 40, 100, 200 }) {
+            auto vec = test_helpers::duplicated_values(size, size);
+            CHECK(count_allocations([&] { gfx::timsort(vec); }) == 0);
+            CHECK(std::ranges::is_sorted(vec));
+        }
+    }
+
+    SECTION( "sort of short strings" ) {
+        std::vector<std::string> vec;
+        for (int value : test_helpers::duplicated_values(40, 40)) {
+            vec.push_back(std::to_string(value));
+        }
+        CHECK(count_allocations([&] { gfx::timsort(vec); }) == 0);
+        CHECK(std::ranges::is_sorted(vec));
+    }
+
+    SECTION( "merge of small ranges" ) {
+        auto vec = test_helpers::duplicated_values(200, 200);
+        std::sort(vec.begin(), vec.begin() + 100);
+        std::sort(vec.begin() + 100, vec.end());
+        CHECK(count_allocations([&] { gfx::timmerge(vec, vec.begin() + 100); }) == 0);
+        CHECK(std::ranges::is_sorted(vec));
+    }
+
+    SECTION( "fixed-size arrays" ) {
+        std::array<int, 150> arr;
+        std::iota(arr.rbegin(), arr.rend(), 0);
+        CHECK(count_allocations([&] { gfx::timsort(arr); }) == 0);
+        CHECK(std::ranges::is_sorted(arr));
+    }
+
+    SECTION( "lists of any size" ) {
+        auto vec = test_helpers::duplicated_values(10000, 10000);
+        std::list<int> lst(vec.begin(), vec.end());
+        CHECK(count_allocations([&] { gfx::timsort(lst); }) == 0);
+        CHECK(std::ranges::is_sorted(lst));
+    }
+}
+
+TEST_CASE( "larger merges allocate" ) {
+    SECTION( "merge larger than the buffer" ) {
+        auto vec = test_helpers::duplicated_values(10000, 10000);
+        CHECK(count_allocations([&] { gfx::timsort(vec); }) > 0);
+        CHECK(std::ranges::is_sorted(vec));
+    }
+
+    SECTION( "policy without a merge buffer" ) {
+        auto vec = test_helpers::duplicated_values(200, 200);
+        std::sort(vec.begin(), vec.begin() + 100);
+        std::sort(vec.begin() + 100, vec.end());
+        auto merge = [&] { gfx::timmerge<no_merge_buffer_policy>(vec, vec.begin() + 100); };
+        CHECK(count_allocations(merge) == 1);
+        CHECK(std::ranges::is_sorted(vec));
+    }
+}
+
+TEST_CASE( "batches of non-contiguous ranges allocate once" ) {
+    SECTION( "deques gathered to a shared buffer" ) {
+        std::vector<std::deque<int>> deques;
+        for (int i = 0; i < 1000; ++i) {
+            auto vec = test_helpers::duplicated_values(200, 200);
+            deques.emplace_back(vec.begin(), vec.end());
+        }
+        CHECK(count_allocations([&] { gfx::timsort_batch(deques); }) == 1);
+        CHECK(std::ranges::all_of(deques, [](auto const& deq) {
+            return std::ranges::is_sorted(deq);
+        }));
+    }
+
+    SECTION( "segments of a deque gathered to a shared buffer" ) {
+        auto vec = test_helpers::duplicated_values(200000, 1000);
+        std::deque<int> deq(vec.begin(), vec.end());
+        std::vector<int> offsets;
+        for (int offset = 0; offset <= 200000; offset += 200) {
+            offsets.push_back(offset);
+        }
+        CHECK(count_allocations([&] { gfx::timsort_segmented(deq, offsets); }) == 1);
+        for (std::size_t i = 0; i + 1 < offsets.size(); ++i) {
+            CHECK(std::is_sorted(deq.begin() + offsets[i], deq.begin() + offsets[i + 1]));
+        }
+    }
+}
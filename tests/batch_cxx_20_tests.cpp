@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include <gfx/timsort_parallel.hpp>
+#include "test_helpers.hpp"
+
+namespace
+{
+    // Ranges of all sizes up to max_size, small ones being the most common
+    std::vector<std::vector<test_helpers::indexed_t>> make_batch(int count, int max_size) {
+        std::vector<std::vector<test_helpers::indexed_t>> res;
+        for (int i = 0; i < count; ++i) {
+            int const size = (i % 4 == 0) ? (i * 7) % (max_size + 1) : (i * 7) % 40;
+            res.push_back(test_helpers::duplicated_pairs(size, 23));
+        }
+        return res;
+    }
+
+    auto stable_sorted(std::vector<std::vector<test_helpers::indexed_t>> const& batch) {
+        std::vector<std::vector<test_helpers::indexed_t>> res;
+        for (auto const& vec : batch) {
+            res.push_back(test_helpers::stable_sorted(vec, &test_helpers::indexed_less));
+        }
+        return res;
+    }
+}
+
+TEST_CASE( "timsort_batch" ) {
+    for (int count : { 0, 1, 5, 100, 1000 }) {
+        auto const batch = make_batch(count, 600);
+        auto const expected = stable_sorted(batch);
+
+        auto copy = batch;
+        auto last_it = gfx::timsort_batch(copy, &test_helpers::indexed_less);
+        CHECK(last_it == copy.end());
+        CHECK(copy == expected);
+
+        copy = batch;
+        gfx::timsort_batch(copy, std::size_t(4), {}, &test_helpers::indexed_t::first);
+        CHECK(copy == expected);
+
+        copy = batch;
+        gfx::timsort_batch(copy, std::size_t(0), &test_helpers::indexed_less);
+        CHECK(copy == expected);
+    }
+
+    SECTION( "spans over one buffer" ) {
+        auto vec = test_helpers::duplicated_values(1000, 1000);
+        std::vector<std::span<int>> spans;
+        for (std::size_t i = 0; i < vec.size(); i += 37) {
+            spans.emplace_back(vec.data() + i, (std::min)(std::size_t(37), vec.size() - i));
+        }
+        gfx::timsort_batch(spans, std::ranges::greater{});
+        for (auto span : spans) {
+            CHECK(std::ranges::is_sorted(span, std::ranges::greater{}));
+        }
+    }
+
+    SECTION( "ranges of deques" ) {
+        auto const batch = make_batch(50, 300);
+        auto const expected = stable_sorted(batch);
+        std::vector<std::deque<test_helpers::indexed_t>> deques;
+        for (auto const& vec : batch) {
+            deques.emplace_back(vec.begin(), vec.end());
+        }
+        gfx::timsort_batch(deques, &test_helpers::indexed_less);
+        CHECK(std::ranges::equal(deques, expected, std::ranges::equal));
+    }
+
+    SECTION( "exceptions are propagated from the threads" ) {
+        auto batch = make_batch(1000, 100);
+        auto throwing_less = [](test_helpers::indexed_t lhs, test_helpers::indexed_t rhs) {
+            if (lhs.first == 13 && rhs.first == 17) {
+                throw std::runtime_error("comparison failure");
+            }
+            return lhs.first < rhs.first;
+        };
+        CHECK_THROWS_AS(gfx::timsort_batch(batch, std::size_t(4), throwing_less),
+                        std::runtime_error);
+    }
+}
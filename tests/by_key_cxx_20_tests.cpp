@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include "test_helpers.hpp"
+
+namespace
+{
+    // Keys with many duplicates, and the initial positions of the keys as values
+    std::vector<int> make_keys(int size) {
+        return test_helpers::duplicated_values(size, size / 4 + 1);
+    }
+}
+
+TEST_CASE( "timsort_by_key" ) {
+    for (int size : { 0, 1, 2, 10, 31, 32, 100, 1000, 10000 }) {
+        auto keys = make_keys(size);
+        auto const expected = test_helpers::stable_sorted(test_helpers::indexed(keys),
+                                                          &test_helpers::indexed_less);
+
+        std::vector<int> ids;
+        std::vector<std::string> names;
+        for (auto const& pair : test_helpers::indexed(keys)) {
+            ids.push_back(pair.second);
+            names.push_back(std::to_string(pair.first));
+        }
+
+        auto last_it = gfx::timsort_by_key(keys, ids, names);
+        CHECK(last_it == keys.end());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            CHECK(keys[i] == expected[i].first);
+            CHECK(ids[i] == expected[i].second);
+            CHECK(names[i] == std::to_string(keys[i]));
+        }
+    }
+
+    SECTION( "partially ordered keys" ) {
+        std::vector<int> keys;
+        for (int i = 0; i < 3000; ++i) {
+            keys.push_back(i < 1000 ? i : (i < 2000 ? 4000 - i : (i * 37) % 500));
+        }
+        auto const expected = test_helpers::stable_sorted(test_helpers::indexed(keys),
+                                                          &test_helpers::indexed_less);
+
+        std::vector<int> ids;
+        for (auto const& pair : test_helpers::indexed(keys)) {
+            ids.push_back(pair.second);
+        }
+        gfx::timsort_by_key(keys, ids);
+        CHECK(std::ranges::equal(keys, expected, {}, {}, &test_helpers::indexed_t::first));
+        CHECK(std::ranges::equal(ids, expected, {}, {}, &test_helpers::indexed_t::second));
+    }
+
+    SECTION( "custom comparison and ranges of values of any kind" ) {
+        auto keys = make_keys(2000);
+        auto const expected = test_helpers::stable_sorted(
+            test_helpers::indexed(keys),
+            [](test_helpers::indexed_t lhs, test_helpers::indexed_t rhs) {
+                return lhs.first > rhs.first;
+            });
+
+        std::deque<int> ids;
+        for (auto const& pair : test_helpers::indexed(keys)) {
+            ids.push_back(pair.second);
+        }
+        std::deque<int> deq_keys(keys.begin(), keys.end());
+        gfx::timsort_by_key(deq_keys, ids, std::greater<>{});
+        CHECK(std::ranges::equal(deq_keys, expected, {}, {}, &test_helpers::indexed_t::first));
+        CHECK(std::ranges::equal(ids, expected, {}, {}, &test_helpers::indexed_t::second));
+    }
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <utility>
+#include <vector>
+#include <version>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include "test_helpers.hpp"
+
+namespace
+{
+    template <std::size_t N>
+    constexpr std::array<int, N> make_sawtooth(int period) {
+        std::array<int, N> arr = {};
+        for (std::size_t i = 0; i < N; ++i) {
+            arr[i] = static_cast<int>(i % static_cast<std::size_t>(period)) * 3
+                   - static_cast<int>(i / static_cast<std::size_t>(period));
+        }
+        return arr;
+    }
+
+    template <std::size_t N>
+    constexpr std::array<int, N> sorted_sawtooth(int period) {
+        auto arr = make_sawtooth<N>(period);
+        gfx::timsort(arr);
+        return arr;
+    }
+}
+
+TEST_CASE( "constexpr timsort of small arrays" ) {
+    constexpr auto arr = sorted_sawtooth<20>(7);
+    STATIC_CHECK(std::ranges::is_sorted(arr));
+
+    constexpr auto pairs = [] {
+        std::array<std::pair<int, int>, 10> res = {};
+        for (int i = 0; i < 10; ++i) {
+            res[static_cast<std::size_t>(i)] = { i % 3, i };
+        }
+        gfx::timsort(res, std::ranges::greater{}, &std::pair<int, int>::first);
+        return res;
+    }();
+    STATIC_CHECK(pairs[0] == std::pair(2, 2));
+    STATIC_CHECK(pairs[1] == std::pair(2, 5));
+    STATIC_CHECK(pairs[9] == std::pair(0, 9));
+}
+
+#ifdef __cpp_lib_constexpr_vector
+TEST_CASE( "constexpr timsort of large arrays" ) {
+    // Large enough to need merges and thus a transient buffer
+    constexpr auto arr = sorted_sawtooth<300>(41);
+    STATIC_CHECK(std::ranges::is_sorted(arr));
+
+    constexpr auto vec_sorted = [] {
+        auto arr = make_sawtooth<200>(13);
+        std::vector<int> vec(arr.begin(), arr.end());
+        gfx::timsort(vec.begin(), vec.end(), std::ranges::greater{});
+        return std::ranges::is_sorted(vec, std::ranges::greater{});
+    }();
+    STATIC_CHECK(vec_sorted);
+}
+
+TEST_CASE( "constexpr timmerge" ) {
+    constexpr auto arr = [] {
+        std::array<int, 100> res = {};
+        for (int i = 0; i < 50; ++i) {
+            res[static_cast<std::size_t>(i)] = i * 2;
+            res[static_cast<std::size_t>(i + 50)] = i * 3;
+        }
+        gfx::timmerge(res, res.begin() + 50);
+        return res;
+    }();
+    STATIC_CHECK(std::ranges::is_sorted(arr));
+}
+#endif
+
+TEST_CASE( "timsort over fixed-size ranges" ) {
+    for (int period : { 1, 5, 31, 100, 1000 }) {
+        auto arr = make_sawtooth<3000>(period);
+        test_helpers::shuffle(arr.begin(), arr.begin() + 500);
+        std::vector<int> expected(arr.begin(), arr.end());
+        std::stable_sort(expected.begin(), expected.end());
+
+        auto copy = arr;
+        CHECK(gfx::timsort(copy) == copy.end());
+        CHECK(std::ranges::equal(copy, expected));
+
+        copy = arr;
+        std::span<int, 3000> span(copy);
+        CHECK(gfx::timsort(span) == span.end());
+        CHECK(std::ranges::equal(copy, expected));
+    }
+
+    int c_array[] = { 5, 3, 9, 1, 1, 0 };
+    CHECK(gfx::timsort(c_array) == std::end(c_array));
+    CHECK(std::ranges::is_sorted(c_array));
+}
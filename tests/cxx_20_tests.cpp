@@ -3,16 +3,46 @@
  * SPDX-License-Identifier: MIT
  */
 #include <algorithm>
+#include <deque>
 #include <iterator>
 #include <numeric>
 #include <random>
+#include <ranges>
 #include <span>
+#include <string>
 #include <vector>
 #include <utility>
 #include <catch2/catch_test_macros.hpp>
 #include <gfx/timsort.hpp>
 #include "test_helpers.hpp"
 
+namespace
+{
+    int live_objects = 0;
+    int constructions = 0;
+
+    // Keeps track of the number of live objects
+    struct tracked {
+        std::string value;
+
+        explicit tracked(int val) : value(std::to_string(val)) {
+            ++live_objects;
+            ++constructions;
+        }
+
+        tracked(tracked&& other) noexcept : value(std::move(other.value)) {
+            ++live_objects;
+            ++constructions;
+        }
+
+        tracked& operator=(tracked&&) noexcept = default;
+
+        ~tracked() {
+            --live_objects;
+        }
+    };
+}
+
 TEST_CASE( "support for temporary types" ) {
     SECTION( "timsort over std::span" ) {
         std::vector<int> vec(50);
@@ -84,3 +114,88 @@ TEST_CASE( "support for sentinels" ) {
         CHECK(last_it == std::default_sentinel);
     }
 }
+
+TEST_CASE( "non-contiguous ranges" ) {
+    SECTION( "timsort over std::deque" ) {
+        std::deque<std::pair<int, int>> deq;
+        for (int i = 0; i < 1000; ++i) {
+            deq.emplace_back(i % 17, i);
+        }
+        test_helpers::shuffle(deq);
+        std::vector<std::pair<int, int>> vec(deq.begin(), deq.end());
+
+        gfx::timsort(deq, {}, &std::pair<int, int>::first);
+        std::ranges::stable_sort(vec, {}, &std::pair<int, int>::first);
+        CHECK(std::ranges::equal(deq, vec));
+    }
+
+    SECTION( "timsort over a transformed view" ) {
+        std::vector<std::pair<int, int>> vec;
+        for (int i = 0; i < 300; ++i) {
+            vec.emplace_back(i, -i);
+        }
+        test_helpers::shuffle(vec);
+        auto seconds = vec | std::views::values;
+        std::vector<int> old_seconds(seconds.begin(), seconds.end());
+
+        auto view = vec | std::views::transform([](std::pair<int, int>& pair) -> int& {
+            return pair.first;
+        });
+        auto last_it = gfx::timsort(view);
+        CHECK(std::ranges::is_sorted(view));
+        CHECK(last_it == view.end());
+        CHECK(std::ranges::equal(seconds, old_seconds));
+    }
+}
+
+TEST_CASE( "lifetime of the elements in the merge buffer" ) {
+    std::vector<int> values(5000);
+    std::iota(values.begin(), values.end(), 0);
+    test_helpers::shuffle(values);
+
+    {
+        std::vector<tracked> vec;
+        vec.reserve(values.size());
+        for (int value : values) {
+            vec.emplace_back(value);
+        }
+        constructions = 0;
+
+        gfx::timsort(vec, {}, &tracked::value);
+        CHECK(std::ranges::is_sorted(vec, {}, &tracked::value));
+        CHECK(live_objects == 5000);
+        // The insertion sort of the runs moves every element to a temporary at most once, and
+        // the merges of runs of at least 16 elements move at most 2500 * log2(5000 / 16) of
+        // them to the buffer
+        CHECK(constructions <= 5000 + 2500 * 9);
+
+        // Only the elements of the smallest run are moved to the buffer
+        std::ranges::rotate(vec, vec.begin() + 1234);
+        constructions = 0;
+        gfx::timmerge(vec, vec.begin() + (5000 - 1234), {}, &tracked::value);
+        CHECK(std::ranges::is_sorted(vec, {}, &tracked::value));
+        CHECK(live_objects == 5000);
+        CHECK(constructions <= 1234);
+    }
+    CHECK(live_objects == 0);
+}
+
+TEST_CASE( "bitwise moves over contiguous iterators" ) {
+    std::vector<std::pair<long, long>> pairs;
+    for (int i = 0; i < 3000; ++i) {
+        pairs.emplace_back(i % 31, i);
+    }
+    test_helpers::shuffle(pairs);
+    auto expected = pairs;
+    std::ranges::stable_sort(expected, {}, &std::pair<long, long>::first);
+
+    std::vector<long> vec;
+    for (auto const& pair : pairs) {
+        vec.push_back(pair.first * 10000 + pair.second);
+    }
+    auto view = std::span(vec);
+    gfx::timsort(view.begin(), view.end(), {}, [](long value) { return value / 10000; });
+    for (std::size_t i = 0; i < vec.size(); ++i) {
+        CHECK(vec[i] == expected[i].first * 10000 + expected[i].second);
+    }
+}
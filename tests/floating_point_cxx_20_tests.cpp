@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <compare>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include "test_helpers.hpp"
+
+namespace
+{
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    constexpr double qnan = std::numeric_limits<double>::quiet_NaN();
+
+    // Values with NaNs of both signs and different payloads, zeros of both signs and duplicates
+    template <typename T>
+    std::vector<T> make_values(int size) {
+        std::vector<T> res;
+        auto const numbers = test_helpers::duplicated_values(size, 1013);
+        for (int i = 0; i < size; ++i) {
+            switch (i % 11) {
+                case 0: res.push_back(std::numeric_limits<T>::quiet_NaN()); break;
+                case 1: res.push_back(-std::numeric_limits<T>::quiet_NaN()); break;
+                case 2: res.push_back(std::bit_cast<T>(std::bit_cast<
+                            std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>
+                        >(std::numeric_limits<T>::quiet_NaN()) | 5)); break;
+                case 3: res.push_back(T(-0.0)); break;
+                case 4: res.push_back(T(0.0)); break;
+                case 5: res.push_back(std::numeric_limits<T>::infinity()); break;
+                case 6: res.push_back(-std::numeric_limits<T>::infinity()); break;
+                default: res.push_back(T(numbers[std::size_t(i)]) / T(7) - T(60)); break;
+            }
+        }
+        test_helpers::shuffle(res);
+        return res;
+    }
+
+    // Compares the representations, NaNs aren't equal to themselves
+    template <typename T>
+    bool same_bits(std::vector<T> const& lhs, std::vector<T> const& rhs) {
+        return std::ranges::equal(lhs, rhs, [](T x, T y) {
+            return std::memcmp(&x, &y, sizeof(T)) == 0;
+        });
+    }
+
+    template <typename T>
+    void check_total_order(int size) {
+        auto vec = make_values<T>(size);
+        auto expected = vec;
+        std::ranges::stable_sort(expected, [](T x, T y) { return std::strong_order(x, y) < 0; });
+
+        gfx::timsort(vec, gfx::total_order_less{});
+        CHECK(same_bits(vec, expected));
+    }
+}
+
+TEST_CASE( "floating-point orders" ) {
+    gfx::total_order_less total;
+    CHECK(total(-qnan, -inf));
+    CHECK(total(-inf, -1.0));
+    CHECK(total(-1.0, -0.0));
+    CHECK(total(-0.0, 0.0));
+    CHECK(total(0.0, 1.0));
+    CHECK(total(1.0, inf));
+    CHECK(total(inf, qnan));
+    CHECK_FALSE(total(qnan, qnan));
+    CHECK(total(-2.0L, -0.0L));
+
+    gfx::nan_last_less nan_last;
+    CHECK(nan_last(inf, qnan));
+    CHECK(nan_last(-inf, -qnan));
+    CHECK_FALSE(nan_last(qnan, -qnan));
+    CHECK_FALSE(nan_last(qnan, 1.0));
+    CHECK_FALSE(nan_last(-0.0, 0.0));
+    CHECK(nan_last(-1.0, 0.0));
+
+    gfx::abbreviate abbrev;
+    CHECK(abbrev(-1.5) < abbrev(-0.5));
+    CHECK(abbrev(0.5f) < abbrev(inf));
+}
+
+TEST_CASE( "timsort with total_order_less" ) {
+    for (int size : { 0, 1, 10, 255, 256, 1000, 5000 }) {
+        check_total_order<double>(size);
+        check_total_order<float>(size);
+    }
+
+    SECTION( "non-contiguous ranges" ) {
+        auto vec = make_values<double>(1000);
+        std::deque<double> deq(vec.begin(), vec.end());
+        gfx::timsort(deq, gfx::total_order_less{});
+        CHECK(std::ranges::is_sorted(deq, gfx::total_order_less{}));
+    }
+
+    SECTION( "projections" ) {
+        std::vector<std::pair<double, int>> vec;
+        for (int i = 0; i < 1000; ++i) {
+            vec.emplace_back(i % 3 == 0 ? qnan : double((i * 7919) % 17), i);
+        }
+        gfx::timsort(vec, gfx::total_order_less{}, &std::pair<double, int>::first);
+        CHECK(std::ranges::is_sorted(vec, gfx::total_order_less{}, &std::pair<double, int>::first));
+        // NaNs are equal in total order when they have the same representation
+        CHECK(std::ranges::is_sorted(vec.end() - 334, vec.end(), {}, &std::pair<double, int>::second));
+    }
+
+    SECTION( "fixed-size ranges" ) {
+        // Large enough to be sorted by keys
+        auto vec = make_values<double>(1000);
+        auto expected = vec;
+        std::ranges::stable_sort(expected, [](double x, double y) {
+            return std::strong_order(x, y) < 0;
+        });
+
+        std::array<double, 1000> arr;
+        std::ranges::copy(vec, arr.begin());
+        gfx::timsort(arr, gfx::total_order_less{});
+        CHECK(same_bits(std::vector<double>(arr.begin(), arr.end()), expected));
+
+        gfx::timsort(std::span<double, 1000>(vec), gfx::total_order_less{});
+        CHECK(same_bits(vec, expected));
+    }
+}
+
+TEST_CASE( "timsort with nan_last_less" ) {
+    for (int size : { 0, 1, 10, 300, 3000 }) {
+        // Values tagged with their original positions to check the stability
+        auto values = make_values<double>(size);
+        std::vector<std::pair<double, int>> vec;
+        for (int i = 0; i < size; ++i) {
+            vec.emplace_back(values[i], i);
+        }
+        auto expected = vec;
+        std::ranges::stable_sort(expected, gfx::nan_last_less{}, &std::pair<double, int>::first);
+
+        gfx::timsort(vec, gfx::nan_last_less{}, &std::pair<double, int>::first);
+        CHECK(std::ranges::equal(vec, expected, {}, &std::pair<double, int>::second,
+                                 &std::pair<double, int>::second));
+
+        auto expected_values = values;
+        std::ranges::stable_sort(expected_values, gfx::nan_last_less{});
+        gfx::timsort(values, gfx::nan_last_less{});
+        CHECK(same_bits(values, expected_values));
+
+        auto floats = make_values<float>(size);
+        auto expected_floats = floats;
+        std::ranges::stable_sort(expected_floats, gfx::nan_last_less{});
+        gfx::timsort(floats, gfx::nan_last_less{});
+        CHECK(same_bits(floats, expected_floats));
+    }
+
+    SECTION( "non-contiguous ranges" ) {
+        auto values = make_values<double>(3000);
+        std::deque<double> deq(values.begin(), values.end());
+        std::ranges::stable_sort(values, gfx::nan_last_less{});
+        gfx::timsort(deq, gfx::nan_last_less{});
+        CHECK(same_bits(std::vector<double>(deq.begin(), deq.end()), values));
+    }
+
+    SECTION( "long double" ) {
+        std::vector<long double> vec = { 2.0L, -0.0L, std::numeric_limits<long double>::quiet_NaN(),
+                                         -3.5L, 0.0L, 1.0L };
+        gfx::timsort(vec, gfx::nan_last_less{});
+        CHECK(std::ranges::is_sorted(vec, gfx::nan_last_less{}));
+        CHECK(std::isnan(vec.back()));
+    }
+
+    SECTION( "fixed-size ranges" ) {
+        std::array<float, 5> arr = { 2.0f, static_cast<float>(qnan), -1.0f, static_cast<float>(-qnan), 0.5f };
+        gfx::timsort(arr, gfx::nan_last_less{});
+        CHECK(arr[0] == -1.0f);
+        CHECK(arr[2] == 2.0f);
+        CHECK(std::signbit(arr[4]));
+
+        auto values = make_values<double>(300);
+        std::array<double, 300> large_arr;
+        std::ranges::copy(values, large_arr.begin());
+        gfx::timsort(large_arr, gfx::nan_last_less{});
+        CHECK(std::ranges::is_sorted(large_arr, gfx::nan_last_less{}));
+        CHECK(std::ranges::all_of(large_arr.end() - 84, large_arr.end(), [](double x) {
+            return std::isnan(x);
+        }));
+    }
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include "test_helpers.hpp"
+
+namespace
+{
+    std::vector<int> make_sorted_with_duplicates(int size) {
+        std::vector<int> vec;
+        for (int i = 0; i < size; ++i) {
+            vec.push_back(i / 3 * 2);
+        }
+        return vec;
+    }
+}
+
+TEST_CASE( "gallop_lower_bound and gallop_upper_bound" ) {
+    for (int size : { 0, 1, 2, 7, 100 }) {
+        auto vec = make_sorted_with_duplicates(size);
+        for (int key = -1; key <= size; ++key) {
+            for (int hint = 0; hint <= size; hint += 3) {
+                auto hint_it = vec.begin() + hint;
+                CHECK(gfx::gallop_lower_bound(vec, key, hint_it) ==
+                      std::ranges::lower_bound(vec, key));
+                CHECK(gfx::gallop_upper_bound(vec, key, hint_it) ==
+                      std::ranges::upper_bound(vec, key));
+            }
+        }
+    }
+}
+
+TEST_CASE( "gallop_lower_bound with a projection" ) {
+    std::vector<std::pair<int, int>> vec;
+    for (int i = 0; i < 50; ++i) {
+        vec.emplace_back(i, 50 - i / 2);
+    }
+
+    auto proj = &std::pair<int, int>::second;
+    auto it = gfx::gallop_lower_bound(vec, 30, vec.begin() + 10, std::ranges::greater{}, proj);
+    CHECK(it == std::ranges::lower_bound(vec, 30, std::ranges::greater{}, proj));
+    it = gfx::gallop_upper_bound(vec.begin(), vec.end(), 30, vec.end() - 1,
+                                 std::ranges::greater{}, proj);
+    CHECK(it == std::ranges::upper_bound(vec, 30, std::ranges::greater{}, proj));
+}
+
+TEST_CASE( "gallop_lower_bound close to the hint" ) {
+    std::vector<int> vec(100000);
+    for (std::size_t i = 0; i < vec.size(); ++i) {
+        vec[i] = static_cast<int>(i);
+    }
+
+    std::size_t comparisons = 0;
+    auto counting_less = [&comparisons](int lhs, int rhs) {
+        ++comparisons;
+        return lhs < rhs;
+    };
+    auto it = gfx::gallop_lower_bound(vec, 50005, vec.begin() + 50000, counting_less);
+    CHECK(*it == 50005);
+    CHECK(comparisons < 10);
+}
+
+TEST_CASE( "gallop bounds over a batch of sorted keys" ) {
+    auto vec = make_sorted_with_duplicates(1000);
+    std::vector<int> keys;
+    for (int i = -5; i < 700; ++i) {
+        keys.push_back(i);
+    }
+    test_helpers::shuffle(keys);
+    keys.resize(300);
+    std::ranges::sort(keys);
+
+    std::vector<std::vector<int>::iterator> lower;
+    auto res = gfx::gallop_lower_bound_batch(vec, keys, std::back_inserter(lower));
+    CHECK(res.in == keys.end());
+    std::vector<std::vector<int>::iterator> upper;
+    gfx::gallop_upper_bound_batch(vec.begin(), vec.end(), keys.begin(), keys.end(),
+                                  std::back_inserter(upper));
+
+    REQUIRE(lower.size() == keys.size());
+    REQUIRE(upper.size() == keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        CHECK(lower[i] == std::ranges::lower_bound(vec, keys[i]));
+        CHECK(upper[i] == std::ranges::upper_bound(vec, keys[i]));
+    }
+}
+
+TEST_CASE( "gallop bounds over a batch of keys in an empty range" ) {
+    std::vector<int> vec;
+    std::vector<int> keys = { 1, 2, 3 };
+    std::vector<std::vector<int>::iterator> lower(keys.size());
+    auto res = gfx::gallop_lower_bound_batch(vec, keys, lower.begin());
+    CHECK(res.out == lower.end());
+    CHECK(std::ranges::all_of(lower, [&](auto it) { return it == vec.end(); }));
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <cstddef>
+#include <ios>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include <gfx/timsort_trace.hpp>
+#include "test_helpers.hpp"
+
+namespace
+{
+    struct recording_hooks {
+        std::vector<gfx::timsort_event> runs;
+        std::vector<gfx::timsort_event> binary_sorts;
+        std::vector<gfx::timsort_event> merges;
+        std::vector<gfx::timsort_event> gallops;
+
+        void on_run(gfx::timsort_event const& event) { runs.push_back(event); }
+        void on_binary_sort(gfx::timsort_event const& event) { binary_sorts.push_back(event); }
+        void on_merge(gfx::timsort_event const& event) { merges.push_back(event); }
+        void on_gallop(gfx::timsort_event const& event) { gallops.push_back(event); }
+    };
+
+    struct merge_counting_hooks {
+        int merges = 0;
+
+        void on_merge(gfx::timsort_event const&) { ++merges; }
+    };
+}
+
+TEST_CASE( "timsort hooks receive the phases of the algorithm" ) {
+    const int size = 20000;
+    auto vec = test_helpers::shuffled_runs(size, 300, 250);
+
+    recording_hooks hooks;
+    gfx::timsort(vec, hooks);
+    CHECK(std::ranges::is_sorted(vec));
+
+    // Every run found is eventually merged with the others
+    REQUIRE(not hooks.runs.empty());
+    CHECK(hooks.merges.size() == hooks.runs.size() - 1);
+    CHECK(hooks.runs.front().offset == 0);
+    for (std::size_t i = 0; i < hooks.runs.size(); ++i) {
+        CHECK(hooks.runs[i].kind == gfx::timsort_event_kind::run);
+        CHECK(hooks.runs[i].start <= hooks.runs[i].end);
+        if (i > 0) {
+            CHECK(hooks.runs[i - 1].offset < hooks.runs[i].offset);
+        }
+    }
+    for (auto const& event : hooks.binary_sorts) {
+        CHECK(event.length >= 32);
+    }
+
+    // The last merge covers the whole range
+    auto const& last_merge = hooks.merges.back();
+    CHECK(last_merge.kind == gfx::timsort_event_kind::merge);
+    CHECK(last_merge.offset == 0);
+    CHECK(last_merge.length + last_merge.length2 == size);
+    CHECK(last_merge.stack_depth == 2);
+    for (auto const& event : hooks.merges) {
+        CHECK(event.stack_depth >= 2);
+        CHECK(event.offset + event.length + event.length2 <= size);
+    }
+
+    // Long sorted subsequences make the merges gallop
+    CHECK(not hooks.gallops.empty());
+}
+
+TEST_CASE( "timmerge hooks" ) {
+    std::vector<int> vec(1000);
+    std::iota(vec.begin(), vec.end(), 0);
+    std::rotate(vec.begin(), vec.begin() + 600, vec.end());
+
+    recording_hooks hooks;
+    gfx::timmerge(vec, vec.begin() + 400, hooks);
+    CHECK(std::ranges::is_sorted(vec));
+    REQUIRE(hooks.merges.size() == 1);
+    CHECK(hooks.merges[0].length == 400);
+    CHECK(hooks.merges[0].length2 == 600);
+    CHECK(hooks.runs.empty());
+}
+
+TEST_CASE( "timsort hooks observing a single phase" ) {
+    auto vec = test_helpers::shuffled_runs(5000, 300, 250);
+    merge_counting_hooks hooks;
+    gfx::timsort(vec.begin(), vec.end(), hooks, std::ranges::greater{});
+    CHECK(std::ranges::is_sorted(vec, std::ranges::greater{}));
+    CHECK(hooks.merges > 0);
+}
+
+TEST_CASE( "chrome_trace_sink writes trace events" ) {
+    std::ostringstream out;
+    std::size_t events = 0;
+    {
+        gfx::chrome_trace_sink sink(out);
+        auto vec = test_helpers::shuffled_runs(3000, 300, 250);
+        auto copy = vec;
+        gfx::timsort(vec, sink);
+
+        recording_hooks hooks;
+        gfx::timsort(copy, hooks);
+        events = hooks.runs.size() + hooks.binary_sorts.size()
+               + hooks.merges.size() + hooks.gallops.size();
+    }
+
+    auto trace = out.str();
+    CHECK(trace.starts_with("{\"traceEvents\":["));
+    CHECK(trace.ends_with("]}\n"));
+    CHECK(trace.find("\"name\":\"merge\"") != std::string::npos);
+    CHECK(trace.find("\"length2\":") != std::string::npos);
+
+    std::size_t complete_events = 0;
+    for (auto pos = trace.find("\"ph\":\"X\""); pos != std::string::npos;
+         pos = trace.find("\"ph\":\"X\"", pos + 1)) {
+        ++complete_events;
+    }
+    CHECK(complete_events == events);
+}
+
+TEST_CASE( "chrome_trace_sink reports files it can't open" ) {
+    CHECK_THROWS_AS(gfx::chrome_trace_sink("no/such/directory/trace.json"), std::ios_base::failure);
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include "test_helpers.hpp"
+
+namespace
+{
+    struct non_movable {
+        int value;
+
+        explicit non_movable(int val) : value(val) {
+        }
+
+        non_movable(non_movable const&) = delete;
+        non_movable& operator=(non_movable const&) = delete;
+    };
+
+    struct node {
+        int value;
+        int order;
+        node* next = nullptr;
+        node* prev = nullptr;
+    };
+
+    using node_hook = gfx::list_member_hook<&node::next, &node::prev>;
+
+    std::vector<int> make_patterned(int size, int pattern) {
+        std::vector<int> vec(size);
+        std::iota(vec.begin(), vec.end(), 0);
+        switch (pattern) {
+            case 0: // random
+                test_helpers::shuffle(vec);
+                break;
+            case 1: // descending
+                std::reverse(vec.begin(), vec.end());
+                break;
+            case 2: // ascending runs
+                for (int i = 0; i < size; i += 100) {
+                    std::reverse(vec.begin() + i, vec.begin() + (std::min)(i + 100, size));
+                }
+                test_helpers::shuffle(vec.begin(), vec.begin() + size / 2);
+                break;
+            default: // many duplicates
+                for (auto& elem: vec) {
+                    elem %= 7;
+                }
+                test_helpers::shuffle(vec);
+                break;
+        }
+        return vec;
+    }
+}
+
+TEST_CASE( "timsort over std::list" ) {
+    for (int size : { 0, 1, 2, 5, 31, 32, 33, 64, 100, 1000, 3000 }) {
+        for (int pattern = 0; pattern < 4; ++pattern) {
+            auto vec = make_patterned(size, pattern);
+            std::list<int> lst(vec.begin(), vec.end());
+
+            auto last_it = gfx::timsort(lst);
+            std::stable_sort(vec.begin(), vec.end());
+            CHECK(last_it == lst.end());
+            CHECK(std::equal(lst.begin(), lst.end(), vec.begin(), vec.end()));
+        }
+    }
+}
+
+TEST_CASE( "timsort over std::list is stable" ) {
+    std::vector<std::pair<int, int>> vec;
+    for (int i = 0; i < 2000; ++i) {
+        vec.emplace_back(i % 13, i);
+    }
+    test_helpers::shuffle(vec);
+    std::list<std::pair<int, int>> lst(vec.begin(), vec.end());
+
+    gfx::timsort(lst, std::ranges::greater{}, &std::pair<int, int>::first);
+    std::stable_sort(vec.begin(), vec.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs.first > rhs.first;
+    });
+    CHECK(std::equal(lst.begin(), lst.end(), vec.begin(), vec.end()));
+}
+
+TEST_CASE( "timsort over std::list relinks nodes" ) {
+    std::vector<int> values(500);
+    std::iota(values.begin(), values.end(), 0);
+    test_helpers::shuffle(values);
+
+    std::list<non_movable> lst;
+    std::vector<non_movable const*> addresses(values.size());
+    for (int value : values) {
+        addresses[value] = &lst.emplace_back(value);
+    }
+
+    gfx::timsort(lst, {}, &non_movable::value);
+    int expected = 0;
+    for (auto const& elem : lst) {
+        CHECK(elem.value == expected);
+        CHECK(&elem == addresses[expected]);
+        ++expected;
+    }
+}
+
+TEST_CASE( "timsort_list over intrusive nodes" ) {
+    const int size = 1500;
+    std::vector<int> values = make_patterned(size, 3);
+
+    // Sort all nodes but the first and last ones to check that the
+    // nodes outside of the range are relinked correctly
+    std::vector<node> nodes(size + 2);
+    for (int i = 0; i < size + 2; ++i) {
+        nodes[i].value = (i == 0 || i == size + 1) ? -1 : values[i - 1];
+        nodes[i].order = i;
+        if (i > 0) {
+            nodes[i].prev = &nodes[i - 1];
+            nodes[i - 1].next = &nodes[i];
+        }
+    }
+
+    node* first = gfx::timsort_list(&nodes[1], &nodes[size + 1], node_hook{},
+                                    std::ranges::less{}, &node::value);
+    CHECK(nodes[0].next == first);
+    CHECK(first->prev == &nodes[0]);
+
+    std::stable_sort(values.begin(), values.end());
+    node const* prev = &nodes[0];
+    node const* current = first;
+    for (int i = 0; i < size; ++i) {
+        REQUIRE(current != &nodes[size + 1]);
+        CHECK(current->prev == prev);
+        CHECK(current->value == values[i]);
+        if (i > 0 && prev->value == current->value) {
+            CHECK(prev->order < current->order);
+        }
+        prev = current;
+        current = current->next;
+    }
+    CHECK(current == &nodes[size + 1]);
+    CHECK(current->prev == prev);
+}
+
+TEST_CASE( "timsort_list over null-terminated intrusive nodes" ) {
+    std::vector<int> values = make_patterned(300, 2);
+    std::vector<node> nodes(values.size());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        nodes[i].value = values[i];
+        nodes[i].order = static_cast<int>(i);
+        if (i > 0) {
+            nodes[i].prev = &nodes[i - 1];
+            nodes[i - 1].next = &nodes[i];
+        }
+    }
+
+    node* first = gfx::timsort_list(&nodes[0], static_cast<node*>(nullptr), node_hook{},
+                                    std::ranges::less{}, &node::value);
+    CHECK(first->prev == nullptr);
+
+    std::sort(values.begin(), values.end());
+    std::vector<int> result;
+    for (node const* current = first; current != nullptr; current = current->next) {
+        result.push_back(current->value);
+    }
+    CHECK(result == values);
+}
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "test_helpers.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include <gfx/timsort_parallel.hpp>
+
+namespace
+{
+    // Executor running every task as soon as it is submitted
+    struct inline_executor {
+        std::size_t tasks = 0;
+
+        void submit(std::function<void()> task) {
+            ++tasks;
+            task();
+        }
+
+        bool try_run_one() {
+            return false;
+        }
+    };
+
+    // Executor running the tasks in order on a single thread
+    class single_thread_executor {
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::deque<std::function<void()>> tasks_;
+        bool stop_ = false;
+        std::thread thread_;
+
+        bool take(std::function<void()>& task) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (tasks_.empty()) {
+                return false;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+            return true;
+        }
+
+    public:
+        single_thread_executor() :
+            thread_([this] {
+                std::function<void()> task;
+                while (true) {
+                    if (take(task)) {
+                        task();
+                        continue;
+                    }
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    wake_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                    if (stop_ && tasks_.empty()) {
+                        return;
+                    }
+                }
+            }) {
+        }
+
+        ~single_thread_executor() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_one();
+            thread_.join();
+        }
+
+        void submit(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                tasks_.push_back(std::move(task));
+            }
+            wake_.notify_one();
+        }
+
+        bool try_run_one() {
+            std::function<void()> task;
+            if (!take(task)) {
+                return false;
+            }
+            task();
+            return true;
+        }
+    };
+
+    // Executors have to let waiting threads run their tasks
+    struct submit_only_executor {
+        void submit(std::function<void()> task) {
+            task();
+        }
+    };
+}
+
+TEST_CASE( "work_stealing_pool" ) {
+    std::atomic<int> count = 0;
+    {
+        gfx::work_stealing_pool pool(3);
+        CHECK(pool.concurrency() == 4);
+        for (int i = 0; i < 100; ++i) {
+            // Tasks submitting tasks go to the queue of their worker
+            pool.submit([&] {
+                for (int j = 0; j < 10; ++j) {
+                    pool.submit([&] { ++count; });
+                }
+            });
+        }
+    }
+    CHECK(count == 1000);
+
+    // Without workers, the tasks are run by the threads waiting for them
+    gfx::work_stealing_pool pool(0);
+    pool.submit([&] { ++count; });
+    CHECK(pool.try_run_one());
+    CHECK_FALSE(pool.try_run_one());
+    CHECK(count == 1001);
+}
+
+TEST_CASE( "parallel timsort" ) {
+    gfx::work_stealing_pool pool(3);
+    inline_executor executor;
+
+    for (int size : { 0, 1, 100, 10000, 100000 }) {
+        auto const vec = test_helpers::duplicated_pairs(size, size / 3 + 1);
+        auto const expected = test_helpers::stable_sorted(vec, &test_helpers::indexed_less);
+
+        auto copy = vec;
+        auto last_it = gfx::timsort(copy, pool, &test_helpers::indexed_less);
+        CHECK(last_it == copy.end());
+        CHECK(copy == expected);
+
+        copy = vec;
+        gfx::timsort(copy.begin(), copy.end(), executor, {}, &test_helpers::indexed_t::first);
+        CHECK(copy == expected);
+
+        std::deque<test_helpers::indexed_t> deq(vec.begin(), vec.end());
+        gfx::timsort(deq, pool, &test_helpers::indexed_less);
+        CHECK(std::ranges::equal(deq, expected));
+    }
+    CHECK(executor.tasks > 0);
+}
+
+TEST_CASE( "parallel timsort of partially sorted inputs" ) {
+    gfx::work_stealing_pool pool(3);
+
+    SECTION( "long natural runs" ) {
+        // Runs longer than the chunks scanned in parallel, and runs of various lengths
+        for (int stride : { 30000, 7000 }) {
+            auto vec = test_helpers::shuffled_runs(200000, stride, stride - 500);
+            auto expected = vec;
+            std::ranges::sort(expected);
+            gfx::timsort(vec, pool);
+            CHECK(vec == expected);
+        }
+    }
+
+    SECTION( "stability across runs" ) {
+        auto vec = test_helpers::duplicated_pairs(150000, 5000);
+        std::stable_sort(vec.begin(), vec.begin() + 60000, &test_helpers::indexed_less);
+        std::stable_sort(vec.begin() + 90000, vec.end(), &test_helpers::indexed_less);
+        auto const expected = test_helpers::stable_sorted(vec, &test_helpers::indexed_less);
+        gfx::timsort(vec, pool, &test_helpers::indexed_less);
+        CHECK(vec == expected);
+    }
+
+    SECTION( "sorted and reversed inputs" ) {
+        std::vector<int> vec(200000);
+        std::iota(vec.begin(), vec.end(), 0);
+        std::atomic<std::size_t> comparisons = 0;
+        auto counting_less = [&comparisons](int lhs, int rhs) {
+            comparisons.fetch_add(1, std::memory_order_relaxed);
+            return lhs < rhs;
+        };
+        gfx::timsort(vec, pool, counting_less);
+        CHECK(std::ranges::is_sorted(vec));
+#ifndef AUDITED_SORTS
+        // The runs are found and merged by galloping, with about one comparison per element
+        CHECK(comparisons < 2 * vec.size());
+#endif
+
+        std::ranges::reverse(vec);
+        gfx::timsort(vec, pool);
+        CHECK(std::ranges::is_sorted(vec));
+    }
+}
+
+TEST_CASE( "parallel timsort from a task of a single-thread executor" ) {
+    STATIC_CHECK(gfx::timsort_executor<single_thread_executor>);
+    STATIC_CHECK(!gfx::timsort_executor<submit_only_executor>);
+
+    // The only thread runs the task calling timsort, which has to run its own tasks
+    single_thread_executor executor;
+    auto vec = test_helpers::duplicated_values(100000, 1000);
+    std::promise<void> done;
+    executor.submit([&] {
+        try {
+            gfx::timsort(vec, executor);
+            done.set_value();
+        } catch (...) {
+            done.set_exception(std::current_exception());
+        }
+    });
+    auto result = done.get_future();
+    REQUIRE(result.wait_for(std::chrono::seconds(60)) == std::future_status::ready);
+    result.get();
+    CHECK(std::ranges::is_sorted(vec));
+}
+
+TEST_CASE( "parallel timmerge" ) {
+    gfx::work_stealing_pool pool(2);
+
+    for (int size : { 0, 10, 50000, 200000 }) {
+        for (int middle : { 0, size / 10, size / 2, size - size / 10 }) {
+            auto vec = test_helpers::duplicated_pairs(size, size / 3 + 1);
+            std::stable_sort(vec.begin(), vec.begin() + middle, &test_helpers::indexed_less);
+            std::stable_sort(vec.begin() + middle, vec.end(), &test_helpers::indexed_less);
+            auto const expected = test_helpers::stable_sorted(vec, &test_helpers::indexed_less);
+
+            gfx::timmerge(vec, vec.begin() + middle, pool, &test_helpers::indexed_less);
+            CHECK(vec == expected);
+        }
+    }
+}
+
+TEST_CASE( "parallel algorithms with executors" ) {
+    gfx::work_stealing_pool pool(2);
+
+    SECTION( "batches" ) {
+        std::vector<std::vector<int>> batch;
+        for (int i = 0; i < 500; ++i) {
+            batch.push_back(test_helpers::duplicated_values((i * 37) % 300, 1000));
+        }
+        gfx::timsort_batch(batch, pool);
+        CHECK(std::ranges::all_of(batch, [](auto const& vec) {
+            return std::ranges::is_sorted(vec);
+        }));
+    }
+
+    SECTION( "exceptions are propagated" ) {
+        auto vec = test_helpers::duplicated_values(100000, 100000);
+        auto throwing_less = [](int lhs, int rhs) {
+            if (lhs == 4242) {
+                throw std::runtime_error("comparison failure");
+            }
+            return lhs < rhs;
+        };
+        CHECK_THROWS_AS(gfx::timsort(vec, pool, throwing_less), std::runtime_error);
+        // The pool is still usable afterwards
+        gfx::timsort(vec, pool);
+        CHECK(std::ranges::is_sorted(vec));
+    }
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <gfx/timsort.hpp>
+#include "distributions.hpp"
+#include "measure.hpp"
+
+// Runs a fixed matrix of timsort and timmerge benchmarks and compares the median
+// timings to a baseline file, the program fails when any case is still slower than
+// the baseline by more than the given tolerance after being measured again. Cases
+// missing from the baseline file are recorded from the current measurements.
+
+namespace
+{
+    struct perf_case {
+        std::string name;
+        std::function<bench::timing(std::size_t runs)> measure;
+    };
+
+    struct options {
+        std::string baseline = "perf_baseline.csv";
+        double tolerance = 0.15;
+        std::size_t runs = 15;
+        bool update = false;
+    };
+
+    template <typename T>
+    void abort_if_unsorted(std::vector<T> const& vec, std::string_view name) {
+        if (!std::is_sorted(vec.begin(), vec.end())) {
+            std::cerr << name << ": the result is not sorted\n";
+            std::abort();
+        }
+    }
+
+    std::string case_name(std::string_view algo, std::string_view type,
+                          bench::distribution dist, std::size_t size) {
+        std::string res(algo);
+        res += '/';
+        res += type;
+        res += '/';
+        res += bench::name(dist);
+        return res + '/' + std::to_string(size);
+    }
+
+    template <typename T>
+    perf_case sort_case(std::string name, bench::distribution dist, std::size_t size) {
+        name = case_name("timsort", name, dist, size);
+        return { name, [=](std::size_t runs) {
+            const auto source = bench::generate<T>(dist, size);
+            std::vector<T> work;
+            return bench::measure(1, runs,
+                [&] { work = source; },
+                [&] { gfx::timsort(work); },
+                [&] { abort_if_unsorted(work, name); }
+            );
+        }};
+    }
+
+    template <typename T>
+    perf_case merge_case(std::string name, bench::distribution dist, std::size_t size) {
+        name = case_name("timmerge", name, dist, size);
+        return { name, [=](std::size_t runs) {
+            auto source = bench::generate<T>(dist, size);
+            const auto middle = static_cast<std::ptrdiff_t>(size / 2);
+            std::sort(source.begin(), source.begin() + middle);
+            std::sort(source.begin() + middle, source.end());
+            std::vector<T> work;
+            return bench::measure(1, runs,
+                [&] { work = source; },
+                [&] { gfx::timmerge(work.begin(), work.begin() + middle, work.end()); },
+                [&] { abort_if_unsorted(work, name); }
+            );
+        }};
+    }
+
+    std::vector<perf_case> make_cases() {
+        using bench::distribution;
+        std::vector<perf_case> cases;
+        for (auto dist : { distribution::shuffled, distribution::sawtooth, distribution::k_swaps,
+                           distribution::random_runs, distribution::zipf }) {
+            cases.push_back(sort_case<int>("int", dist, 100000));
+            cases.push_back(sort_case<std::string>("string", dist, 20000));
+        }
+        for (auto dist : { distribution::shuffled, distribution::few_unique }) {
+            cases.push_back(merge_case<int>("int", dist, 100000));
+            cases.push_back(merge_case<std::string>("string", dist, 20000));
+        }
+        return cases;
+    }
+
+    std::map<std::string, double> read_baseline(std::string const& path) {
+        std::map<std::string, double> res;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            auto comma = line.rfind(',');
+            if (line.empty() || line[0] == '#' || comma == std::string::npos) {
+                continue;
+            }
+            try {
+                res[line.substr(0, comma)] = std::stod(line.substr(comma + 1));
+            } catch (std::exception const&) {
+                // Ignore malformed lines, the matching cases are re-recorded
+            }
+        }
+        return res;
+    }
+
+    bool write_baseline(std::string const& path, std::map<std::string, double> const& medians) {
+        std::ofstream file(path);
+        file << "# case,median_ns\n" << std::fixed << std::setprecision(0);
+        for (auto const& [name, median] : medians) {
+            file << name << ',' << median << '\n';
+        }
+        return static_cast<bool>(file);
+    }
+
+    options parse_options(int argc, const char *argv[]) {
+        options opts;
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            auto eq = arg.find('=');
+            auto key = arg.substr(0, eq);
+            auto value = std::string(eq == std::string_view::npos ? "" : arg.substr(eq + 1));
+            try {
+                if (key == "--baseline") {
+                    opts.baseline = value;
+                } else if (key == "--tolerance") {
+                    opts.tolerance = std::stod(value);
+                } else if (key == "--runs") {
+                    opts.runs = (std::max)(static_cast<std::size_t>(std::stoul(value)),
+                                           std::size_t(1));
+                } else if (key == "--update") {
+                    opts.update = true;
+                } else {
+                    throw std::invalid_argument(std::string(arg));
+                }
+            } catch (std::exception const&) {
+                std::cerr << "usage: perf_regression [--baseline=FILE] [--tolerance=RATIO]"
+                             " [--runs=N] [--update]\n";
+                std::exit(EXIT_FAILURE);
+            }
+        }
+        return opts;
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    const options opts = parse_options(argc, argv);
+    auto baseline = opts.update ? std::map<std::string, double>{} : read_baseline(opts.baseline);
+
+    std::cout << "baseline: " << opts.baseline << ", median of " << opts.runs
+              << " runs, tolerance " << opts.tolerance * 100 << "%\n\n"
+              << std::left << std::setw(36) << "case" << std::right
+              << std::setw(16) << "baseline (us)" << std::setw(16) << "current (us)"
+              << std::setw(10) << "ratio" << "  status\n"
+              << std::fixed << std::setprecision(2);
+
+    std::vector<std::string> regressions;
+    bool recorded = false;
+    for (auto const& test : make_cases()) {
+        double median = test.measure(opts.runs).median_ns;
+        auto it = baseline.find(test.name);
+        std::string status;
+        double ratio = 0.0;
+        if (it == baseline.end()) {
+            baseline[test.name] = median;
+            recorded = true;
+            status = "recorded";
+        } else {
+            ratio = median / it->second;
+            // Measure again before reporting a regression to weed out
+            // one-off hiccups from the system
+            for (int retry = 0; retry < 2 && ratio > 1.0 + opts.tolerance; ++retry) {
+                median = (std::min)(median, test.measure(opts.runs).median_ns);
+                ratio = median / it->second;
+            }
+            if (ratio > 1.0 + opts.tolerance) {
+                status = "REGRESSION";
+                regressions.push_back(test.name);
+            } else {
+                status = ratio < 1.0 - opts.tolerance ? "improved" : "ok";
+            }
+        }
+
+        std::cout << std::left << std::setw(36) << test.name << std::right << std::setw(16);
+        if (ratio != 0.0) {
+            std::cout << baseline[test.name] / 1e3;
+        } else {
+            std::cout << '-';
+        }
+        std::cout << std::setw(16) << median / 1e3 << std::setw(10);
+        if (ratio != 0.0) {
+            std::cout << ratio;
+        } else {
+            std::cout << '-';
+        }
+        std::cout << "  " << status << std::endl;
+    }
+
+    if (recorded && !write_baseline(opts.baseline, baseline)) {
+        std::cerr << "\ncould not write the baseline to " << opts.baseline << '\n';
+        return EXIT_FAILURE;
+    }
+
+    if (!regressions.empty()) {
+        std::cout << '\n' << regressions.size() << " case(s) regressed by more than "
+                  << opts.tolerance * 100 << "%:\n";
+        for (auto const& name : regressions) {
+            std::cout << "  " << name << '\n';
+        }
+        std::cout << "rerun with --update to accept the new timings as the baseline\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "\nno regression detected\n";
+}
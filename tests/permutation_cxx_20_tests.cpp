@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include "test_helpers.hpp"
+
+TEST_CASE( "timsort_indices" ) {
+    std::vector<std::pair<int, int>> vec;
+    for (int i = 0; i < 1000; ++i) {
+        vec.emplace_back(i % 23, i);
+    }
+    test_helpers::shuffle(vec);
+    auto const original = vec;
+
+    SECTION( "returns a stable sorting permutation" ) {
+        auto perm = gfx::timsort_indices(vec, std::ranges::greater{}, &std::pair<int, int>::first);
+        CHECK(vec == original);
+        REQUIRE(perm.size() == vec.size());
+
+        std::ranges::stable_sort(vec, std::ranges::greater{}, &std::pair<int, int>::first);
+        for (std::size_t i = 0; i < perm.size(); ++i) {
+            CHECK(original[perm[i]] == vec[i]);
+        }
+    }
+
+    SECTION( "works with iterators and sentinels" ) {
+        auto perm = gfx::timsort_indices(std::counted_iterator(vec.begin(), 500),
+                                         std::default_sentinel);
+        CHECK(perm.size() == 500);
+        CHECK(std::ranges::is_sorted(perm, {}, [&](auto index) { return vec[index]; }));
+    }
+
+    SECTION( "empty range" ) {
+        std::vector<int> empty;
+        CHECK(gfx::timsort_indices(empty).empty());
+    }
+}
+
+TEST_CASE( "apply_permutation" ) {
+    std::deque<std::string> values;
+    std::vector<int> keys;
+    for (int i = 0; i < 777; ++i) {
+        keys.push_back((i * 37) % 101);
+        values.push_back(std::to_string(i));
+    }
+    test_helpers::shuffle(keys);
+
+    auto perm = gfx::timsort_indices(keys);
+    std::vector<std::string> expected;
+    for (auto index : perm) {
+        expected.push_back(values[index]);
+    }
+
+    SECTION( "reorders associated ranges" ) {
+        auto last_it = gfx::apply_permutation(values, perm);
+        CHECK(last_it == values.end());
+        CHECK(std::ranges::equal(values, expected));
+
+        gfx::apply_permutation(keys, perm);
+        CHECK(std::ranges::is_sorted(keys));
+    }
+
+    SECTION( "accepts unsigned indices" ) {
+        std::vector<std::size_t> unsigned_perm(perm.begin(), perm.end());
+        gfx::apply_permutation(values.begin(), values.end(), unsigned_perm);
+        CHECK(std::ranges::equal(values, expected));
+    }
+
+    SECTION( "identity permutation" ) {
+        std::vector<int> identity(values.size());
+        for (std::size_t i = 0; i < identity.size(); ++i) {
+            identity[i] = static_cast<int>(i);
+        }
+        auto const copy = values;
+        gfx::apply_permutation(values, identity);
+        CHECK(values == copy);
+    }
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include "test_helpers.hpp"
+
+namespace
+{
+    struct short_runs_policy : gfx::timsort_default_policy {
+        static constexpr std::ptrdiff_t min_merge = 4;
+        static constexpr int min_gallop = 2;
+        static constexpr int gallop_penalty = 1;
+    };
+
+    struct eager_gallop_policy : gfx::timsort_default_policy {
+        static constexpr int min_gallop = 1;
+        static constexpr int min_gallop_floor = 3;
+    };
+
+    std::size_t min_run_length_calls = 0;
+
+    struct fixed_runs_policy : gfx::timsort_default_policy {
+        static std::ptrdiff_t min_run_length(std::ptrdiff_t n) {
+            ++min_run_length_calls;
+            return (std::min)(n, std::ptrdiff_t(8));
+        }
+    };
+
+    struct tuned_value {
+        int value;
+
+        friend bool operator==(tuned_value const&, tuned_value const&) = default;
+        friend auto operator<=>(tuned_value const&, tuned_value const&) = default;
+    };
+
+    template <typename Policy>
+    void check_stable_sort(int size) {
+        auto vec = test_helpers::duplicated_pairs(size, 17);
+        auto const expected = test_helpers::stable_sorted(vec, &test_helpers::indexed_less);
+
+        gfx::timsort<Policy>(vec.begin(), vec.end(), &test_helpers::indexed_less);
+        CHECK(vec == expected);
+
+        auto deq = std::deque<test_helpers::indexed_t>(expected.rbegin(), expected.rend());
+        gfx::timsort<Policy>(deq, {}, &test_helpers::indexed_t::first);
+        CHECK(std::ranges::is_sorted(deq, {}, &test_helpers::indexed_t::first));
+    }
+}
+
+template <>
+struct gfx::timsort_traits<tuned_value> : fixed_runs_policy {};
+
+TEST_CASE( "default tuning policies" ) {
+    STATIC_REQUIRE( gfx::timsort_policy<gfx::timsort_default_policy> );
+    STATIC_REQUIRE( gfx::timsort_policy<short_runs_policy> );
+    STATIC_REQUIRE( gfx::timsort_policy<fixed_runs_policy> );
+    STATIC_REQUIRE( not gfx::timsort_policy<int> );
+
+    // The tuning macros may come from a header generated for the machine
+    STATIC_REQUIRE( gfx::timsort_traits<int>::min_merge == GFX_TIMSORT_TUNING_MIN_MERGE );
+    STATIC_REQUIRE( gfx::timsort_traits<double*>::min_gallop == GFX_TIMSORT_TUNING_MIN_GALLOP );
+    STATIC_REQUIRE( gfx::timsort_traits<std::string>::min_merge
+                    == GFX_TIMSORT_TUNING_EXPENSIVE_MIN_MERGE );
+    STATIC_REQUIRE( gfx::timsort_traits<std::array<double, 8>>::min_gallop
+                    == GFX_TIMSORT_TUNING_EXPENSIVE_MIN_GALLOP );
+    STATIC_REQUIRE( gfx::timsort_traits<std::string>::gallop_penalty == 2 );
+}
+
+TEST_CASE( "timsort with custom policies" ) {
+    for (int size : { 0, 1, 3, 10, 64, 100, 1000, 5000 }) {
+        check_stable_sort<short_runs_policy>(size);
+        check_stable_sort<eager_gallop_policy>(size);
+        check_stable_sort<fixed_runs_policy>(size);
+    }
+
+    SECTION( "min_run_length replaces the default strategy" ) {
+        std::vector<int> vec(1000);
+        std::iota(vec.begin(), vec.end(), 0);
+        test_helpers::shuffle(vec);
+
+        min_run_length_calls = 0;
+        gfx::timsort<fixed_runs_policy>(vec);
+        CHECK(std::ranges::is_sorted(vec));
+        CHECK(min_run_length_calls > 0);
+    }
+
+    SECTION( "fixed-size ranges" ) {
+        std::array<int, 100> arr;
+        std::iota(arr.rbegin(), arr.rend(), 0);
+        gfx::timsort<short_runs_policy>(arr);
+        CHECK(std::ranges::is_sorted(arr));
+    }
+
+    SECTION( "specialized timsort_traits" ) {
+        std::vector<tuned_value> vec;
+        for (int i = 0; i < 500; ++i) {
+            vec.push_back({ (i * 37) % 500 });
+        }
+
+        min_run_length_calls = 0;
+        gfx::timsort(vec);
+        CHECK(std::ranges::is_sorted(vec));
+        CHECK(min_run_length_calls > 0);
+
+        std::list<tuned_value> lst(vec.rbegin(), vec.rend());
+        min_run_length_calls = 0;
+        gfx::timsort(lst);
+        CHECK(std::ranges::is_sorted(lst));
+        CHECK(min_run_length_calls > 0);
+    }
+
+    SECTION( "lists" ) {
+        for (int size : { 0, 1, 3, 10, 100, 1000 }) {
+            auto vec = test_helpers::duplicated_pairs(size, 17);
+            auto const expected = test_helpers::stable_sorted(vec, &test_helpers::indexed_less);
+
+            std::list<test_helpers::indexed_t> lst(vec.begin(), vec.end());
+            gfx::timsort<short_runs_policy>(lst, {}, &test_helpers::indexed_t::first);
+            CHECK(std::ranges::equal(lst, expected));
+
+            lst.assign(vec.begin(), vec.end());
+            gfx::timsort<eager_gallop_policy>(lst, &test_helpers::indexed_less);
+            CHECK(std::ranges::equal(lst, expected));
+        }
+    }
+}
+
+TEST_CASE( "timmerge with custom policies" ) {
+    for (int size : { 0, 1, 10, 100, 1000 }) {
+        auto vec = test_helpers::duplicated_pairs(size, 17);
+        auto middle = vec.begin() + size / 3;
+        std::stable_sort(vec.begin(), middle, &test_helpers::indexed_less);
+        std::stable_sort(middle, vec.end(), &test_helpers::indexed_less);
+        auto const expected = test_helpers::stable_sorted(vec, &test_helpers::indexed_less);
+
+        auto copy = vec;
+        gfx::timmerge<short_runs_policy>(copy.begin(), copy.begin() + size / 3, copy.end(),
+                                         &test_helpers::indexed_less);
+        CHECK(copy == expected);
+
+        gfx::timmerge<eager_gallop_policy>(vec, vec.begin() + size / 3,
+                                           &test_helpers::indexed_less);
+        CHECK(vec == expected);
+    }
+}
+
+TEST_CASE( "galloping threshold never drops below the floor" ) {
+    // Alternating long and short runs make galloping pay off across merges
+    std::vector<int> vec;
+    for (int i = 0; i < 2000; ++i) {
+        vec.push_back(i % 200 < 190 ? i : -i);
+    }
+
+    gfx::timsort_stats stats;
+    gfx::timsort(vec, stats);
+    CHECK(std::ranges::is_sorted(vec));
+    CHECK(stats.min_gallop >= gfx::timsort_default_policy::min_gallop_floor);
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include "test_helpers.hpp"
+
+namespace
+{
+    // Concatenation of sorted chunks of the given sizes, and the offsets of their ends
+    std::pair<std::vector<test_helpers::indexed_t>, std::vector<std::size_t>>
+    make_chunks(std::vector<int> const& sizes) {
+        std::vector<int> values;
+        std::vector<std::size_t> boundaries;
+        for (int size : sizes) {
+            auto chunk = test_helpers::duplicated_values(size, 101);
+            std::sort(chunk.begin(), chunk.end());
+            values.insert(values.end(), chunk.begin(), chunk.end());
+            boundaries.push_back(values.size());
+        }
+        return { test_helpers::indexed(values), boundaries };
+    }
+}
+
+TEST_CASE( "timsort_runs" ) {
+    std::vector<std::vector<int>> chunk_sizes = {
+        {},
+        { 0 },
+        { 1000 },
+        { 3, 5, 2, 1, 7, 1, 1, 4 },
+        { 500, 500, 500, 500 },
+        { 1000, 10, 1, 300, 3, 64, 2000, 1 },
+        std::vector<int>(300, 7),
+    };
+
+    for (auto const& sizes : chunk_sizes) {
+        auto [vec, boundaries] = make_chunks(sizes);
+        auto const expected = test_helpers::stable_sorted(vec, &test_helpers::indexed_less);
+
+        auto copy = vec;
+        auto last_it = gfx::timsort_runs(copy, boundaries, &test_helpers::indexed_less);
+        CHECK(last_it == copy.end());
+        CHECK(copy == expected);
+
+        // Offsets of the beginnings of the runs, with empty runs
+        std::vector<int> starts = { 0, 0 };
+        for (auto boundary : boundaries) {
+            starts.push_back(static_cast<int>(boundary));
+        }
+        std::deque<test_helpers::indexed_t> deq(vec.begin(), vec.end());
+        gfx::timsort_runs(deq.begin(), deq.end(), starts, {}, &test_helpers::indexed_t::first);
+        CHECK(std::ranges::equal(deq, expected));
+    }
+
+    SECTION( "the runs aren't scanned" ) {
+        auto [vec, boundaries] = make_chunks({ 1000, 1000 });
+        auto copy = vec;
+        std::size_t comparisons = 0;
+        auto counted_less = [&](int lhs, int rhs) {
+            ++comparisons;
+            return lhs < rhs;
+        };
+
+        gfx::timsort_runs(vec, boundaries, counted_less, &test_helpers::indexed_t::first);
+        CHECK(std::ranges::is_sorted(vec, {}, &test_helpers::indexed_t::first));
+        auto const runs_comparisons = comparisons;
+
+        comparisons = 0;
+        gfx::timsort(copy, counted_less, &test_helpers::indexed_t::first);
+        CHECK(copy == vec);
+        CHECK(runs_comparisons <= comparisons);
+    }
+}
+
+TEST_CASE( "timsort_tail" ) {
+    for (int prefix : { 0, 1, 10, 1000 }) {
+        for (int tail : { 0, 1, 10, 31, 1000 }) {
+            auto [vec, boundaries] = make_chunks({ prefix, tail });
+            test_helpers::shuffle(vec.begin() + prefix, vec.end());
+            auto const expected = test_helpers::stable_sorted(vec, &test_helpers::indexed_less);
+
+            auto copy = vec;
+            auto last_it = gfx::timsort_tail(copy, copy.begin() + prefix,
+                                             &test_helpers::indexed_less);
+            CHECK(last_it == copy.end());
+            CHECK(copy == expected);
+
+            std::deque<test_helpers::indexed_t> deq(vec.begin(), vec.end());
+            gfx::timsort_tail(deq.begin(), deq.begin() + prefix, deq.end(),
+                              {}, &test_helpers::indexed_t::first);
+            CHECK(std::ranges::equal(deq, expected));
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include <gfx/timsort_parallel.hpp>
+#include "test_helpers.hpp"
+
+namespace
+{
+    // Elements and offsets of segments of the given sizes
+    struct csr {
+        std::vector<test_helpers::indexed_t> data;
+        std::vector<std::uint32_t> offsets = { 0 };
+    };
+
+    csr make_csr(std::vector<int> const& sizes) {
+        csr res;
+        std::vector<int> values;
+        for (int size : sizes) {
+            auto segment = test_helpers::duplicated_values(size, 17);
+            values.insert(values.end(), segment.begin(), segment.end());
+            res.offsets.push_back(static_cast<std::uint32_t>(values.size()));
+        }
+        res.data = test_helpers::indexed(values);
+        return res;
+    }
+
+    auto stable_sorted_segments(std::vector<test_helpers::indexed_t> const& data,
+                                std::vector<std::uint32_t> const& offsets) {
+        std::vector<test_helpers::indexed_t> res;
+        for (std::size_t i = 0; i + 1 < offsets.size(); ++i) {
+            auto segment = std::vector(data.begin() + offsets[i], data.begin() + offsets[i + 1]);
+            segment = test_helpers::stable_sorted(segment, &test_helpers::indexed_less);
+            res.insert(res.end(), segment.begin(), segment.end());
+        }
+        return res;
+    }
+}
+
+TEST_CASE( "timsort_segmented" ) {
+    std::vector<std::vector<int>> segment_sizes = {
+        {},
+        { 0, 0 },
+        { 2, 3, 4, 5, 1, 0, 2 },
+        { 1000 },
+        std::vector<int>(2000, 3),
+    };
+    std::vector<int> mixed;
+    for (int i = 0; i < 500; ++i) {
+        mixed.push_back(i % 50 == 0 ? 700 : (i * 13) % 70);
+    }
+    segment_sizes.push_back(mixed);
+
+    for (auto const& sizes : segment_sizes) {
+        auto [data, offsets] = make_csr(sizes);
+        auto const expected = stable_sorted_segments(data, offsets);
+
+        auto copy = data;
+        auto last_it = gfx::timsort_segmented(copy, offsets, &test_helpers::indexed_less);
+        CHECK(last_it == copy.end());
+        CHECK(copy == expected);
+
+        copy = data;
+        gfx::timsort_segmented(copy, offsets, std::size_t(3), {}, &test_helpers::indexed_t::first);
+        CHECK(copy == expected);
+
+        std::deque<test_helpers::indexed_t> deq(data.begin(), data.end());
+        gfx::timsort_segmented(deq, offsets, &test_helpers::indexed_less);
+        CHECK(std::ranges::equal(deq, expected));
+    }
+
+    SECTION( "elements outside of the segments are left alone" ) {
+        std::vector<int> vec = { 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+        std::vector<int> offsets = { 2, 5, 5, 8 };
+        gfx::timsort_segmented(vec, offsets);
+        CHECK(vec == std::vector<int>{ 9, 8, 5, 6, 7, 2, 3, 4, 1, 0 });
+    }
+}
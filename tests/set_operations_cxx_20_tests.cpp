@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "test_helpers.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+
+namespace
+{
+    std::vector<int> make_sorted(std::size_t size, int max_value) {
+        thread_local std::mt19937 engine(Catch::rngSeed());
+        std::uniform_int_distribution<int> dist(0, max_value);
+        std::vector<int> vec(size);
+        for (auto& elem : vec) {
+            elem = dist(engine);
+        }
+        std::ranges::sort(vec);
+        return vec;
+    }
+
+    struct counting_less {
+        std::size_t* count;
+
+        bool operator()(int lhs, int rhs) const {
+            ++*count;
+            return lhs < rhs;
+        }
+    };
+}
+
+TEST_CASE( "galloping set operations" ) {
+    std::pair<std::size_t, int> const configs[] = {
+        { 0, 10 }, { 1, 10 }, { 10, 5 }, { 100, 50 }, { 1000, 100000 }, { 5000, 300 },
+    };
+
+    for (auto [size1, max1] : configs) {
+        for (auto [size2, max2] : configs) {
+            auto const vec1 = make_sorted(size1, max1);
+            auto const vec2 = make_sorted(size2, max2);
+            std::vector<int> expected;
+            std::vector<int> result;
+
+            std::ranges::set_union(vec1, vec2, std::back_inserter(expected));
+            gfx::timset_union(vec1, vec2, std::back_inserter(result));
+            CHECK(result == expected);
+
+            expected.clear();
+            result.clear();
+            std::ranges::set_intersection(vec1, vec2, std::back_inserter(expected));
+            gfx::timset_intersection(vec1, vec2, std::back_inserter(result));
+            CHECK(result == expected);
+
+            expected.clear();
+            result.clear();
+            std::ranges::set_difference(vec1, vec2, std::back_inserter(expected));
+            gfx::timset_difference(vec1, vec2, std::back_inserter(result));
+            CHECK(result == expected);
+
+            expected.clear();
+            result.clear();
+            std::ranges::set_symmetric_difference(vec1, vec2, std::back_inserter(expected));
+            gfx::timset_symmetric_difference(vec1, vec2, std::back_inserter(result));
+            CHECK(result == expected);
+        }
+    }
+}
+
+TEST_CASE( "galloping set operations with projections" ) {
+    std::vector<std::pair<int, int>> vec1;
+    std::vector<std::pair<int, int>> vec2;
+    for (int i = 0; i < 500; ++i) {
+        vec1.emplace_back(i / 3, i);
+        vec2.emplace_back(-i, i * 2);
+    }
+
+    std::vector<std::pair<int, int>> result;
+    auto [in1, in2, out] = gfx::timset_intersection(vec1, vec2, std::back_inserter(result), {},
+                                                    &std::pair<int, int>::first,
+                                                    &std::pair<int, int>::second);
+    CHECK(in1 == vec1.end());
+    CHECK(in2 == vec2.end());
+
+    std::vector<std::pair<int, int>> expected;
+    std::ranges::set_intersection(vec1, vec2, std::back_inserter(expected), {},
+                                  &std::pair<int, int>::first, &std::pair<int, int>::second);
+    CHECK(result == expected);
+}
+
+TEST_CASE( "galloping set operations on skewed inputs" ) {
+    auto const small = make_sorted(20, 1000000);
+    auto const big = make_sorted(100000, 1000000);
+
+    std::size_t comparisons = 0;
+    std::vector<int> result;
+    gfx::timset_intersection(small, big, std::back_inserter(result),
+                             counting_less{&comparisons});
+
+    std::vector<int> expected;
+    std::ranges::set_intersection(small, big, std::back_inserter(expected));
+    CHECK(result == expected);
+#ifndef AUDITED_SORTS
+    // A linear walk would need about 100000 comparisons
+    CHECK(comparisons < 2000);
+#endif
+}
+
+TEST_CASE( "merge_join" ) {
+    std::vector<std::pair<int, int>> left;
+    std::vector<std::pair<int, int>> right;
+    for (int i = 0; i < 300; ++i) {
+        left.emplace_back(i / 4, i);
+        right.emplace_back(i / 3 + 20, -i);
+    }
+
+    std::vector<std::pair<int, int>> expected;
+    for (auto const& lhs : left) {
+        for (auto const& rhs : right) {
+            if (lhs.first == rhs.first) {
+                expected.emplace_back(lhs.second, rhs.second);
+            }
+        }
+    }
+
+    std::vector<std::pair<int, int>> result;
+    gfx::merge_join(left, right, [&result](auto const& lhs, auto const& rhs) {
+        result.emplace_back(lhs.second, rhs.second);
+    }, {}, &std::pair<int, int>::first, &std::pair<int, int>::first);
+    CHECK(result == expected);
+}
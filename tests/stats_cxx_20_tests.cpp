@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "test_helpers.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <numeric>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+
+namespace
+{
+    std::size_t move_count = 0;
+
+    struct move_counting {
+        int value;
+
+        explicit move_counting(int val) : value(val) {
+        }
+
+        move_counting(move_counting&& other) noexcept : value(other.value) {
+            ++move_count;
+        }
+
+        move_counting& operator=(move_counting&& other) noexcept {
+            value = other.value;
+            ++move_count;
+            return *this;
+        }
+    };
+
+    template <typename Container>
+    Container make_container(std::vector<int> const& values) {
+        Container res;
+        for (int value : values) {
+            res.emplace_back(value);
+        }
+        return res;
+    }
+}
+
+TEST_CASE( "timsort_stats counts comparisons and moves" ) {
+    for (int size : { 0, 1, 10, 31, 32, 100, 1000, 10000 }) {
+        // Random runs of various lengths
+        auto values = test_helpers::shuffled_runs(size, 150, 100);
+        auto vec = make_container<std::vector<move_counting>>(values);
+
+        std::size_t comparisons = 0;
+        auto counting_less = [&comparisons](int lhs, int rhs) {
+            ++comparisons;
+            return lhs < rhs;
+        };
+
+        gfx::timsort_stats stats;
+        move_count = 0;
+        gfx::timsort(vec, stats, counting_less, &move_counting::value);
+        CHECK(std::ranges::is_sorted(vec, {}, &move_counting::value));
+#ifndef AUDITED_SORTS
+        CHECK(stats.comparisons == comparisons);
+#endif
+        CHECK(stats.moves == move_count);
+
+        std::size_t histogram_runs = 0;
+        for (auto count : stats.run_lengths) {
+            histogram_runs += count;
+        }
+        CHECK(histogram_runs == stats.runs);
+        CHECK(stats.binary_sort_extensions <= stats.runs);
+        if (size >= 1000) {
+            CHECK(stats.merge_lo_calls + stats.merge_hi_calls > 0);
+            CHECK(stats.peak_tmp_bytes > 0);
+            CHECK(stats.peak_pending_bytes > 0);
+        }
+    }
+}
+
+TEST_CASE( "timsort_stats over non-contiguous ranges" ) {
+    auto values = test_helpers::shuffled_runs(5000, 150, 100);
+    auto deq = make_container<std::deque<move_counting>>(values);
+
+    gfx::timsort_stats stats;
+    move_count = 0;
+    gfx::timsort(deq.begin(), deq.end(), stats, std::ranges::less{}, &move_counting::value);
+    CHECK(std::ranges::is_sorted(deq, {}, &move_counting::value));
+    CHECK(stats.moves == move_count);
+    CHECK(stats.peak_tmp_bytes >= deq.size() * sizeof(move_counting));
+}
+
+TEST_CASE( "timsort_stats over patterned inputs" ) {
+    const int size = 3000;
+    std::vector<int> vec(size);
+    std::iota(vec.begin(), vec.end(), 0);
+
+    gfx::timsort_stats stats;
+    gfx::timsort(vec, stats);
+    CHECK(stats.moves == 0);
+    CHECK(stats.runs == 1);
+    CHECK(stats.run_lengths[11] == 1);
+    CHECK(stats.merge_lo_calls + stats.merge_hi_calls == 0);
+
+    // Statistics accumulate across calls
+    std::ranges::reverse(vec);
+    gfx::timsort(vec, stats);
+    CHECK(stats.moves == 3 * (size / 2));
+    CHECK(stats.runs == 2);
+    CHECK(stats.run_lengths[11] == 2);
+}
+
+TEST_CASE( "timsort_stats with timmerge" ) {
+    std::vector<int> vec(2000);
+    for (int i = 0; i < 1000; ++i) {
+        vec[i] = 2 * i;
+        vec[i + 1000] = 2 * i + 1;
+    }
+
+    gfx::timsort_stats stats;
+    gfx::timmerge(vec, vec.begin() + 1000, stats);
+    CHECK(std::ranges::is_sorted(vec));
+    CHECK(stats.merge_lo_calls + stats.merge_hi_calls == 1);
+    CHECK(stats.comparisons > 0);
+    CHECK(stats.moves > 0);
+    CHECK(stats.min_gallop >= 1);
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2024 Morwenn.
+ * SPDX-License-Identifier: MIT
+ */
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <gfx/timsort.hpp>
+#include "test_helpers.hpp"
+
+namespace
+{
+    // Character traits counting the characters compared
+    std::size_t compared_chars = 0;
+
+    struct counting_traits : std::char_traits<char> {
+        static bool eq(char lhs, char rhs) {
+            ++compared_chars;
+            return lhs == rhs;
+        }
+
+        static bool lt(char lhs, char rhs) {
+            ++compared_chars;
+            return static_cast<unsigned char>(lhs) < static_cast<unsigned char>(rhs);
+        }
+
+        static int compare(const char* lhs, const char* rhs, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                if (!eq(lhs[i], rhs[i])) {
+                    return lt(lhs[i], rhs[i]) ? -1 : 1;
+                }
+            }
+            return 0;
+        }
+    };
+
+    using counted_string = std::basic_string<char, counting_traits>;
+
+    // Strings sharing long prefixes, some of them prefixes of others, with duplicates
+    std::vector<std::string> make_urls(int size) {
+        std::vector<std::string> res;
+        auto const ids = test_helpers::duplicated_values(size, size / 2 + 1);
+        for (int i = 0; i < size; ++i) {
+            std::string url = "https://downloads.example.com/releases/nightly/2024-10-18/linux/";
+            url += (i % 3 == 0) ? "static/images/" : "api/v2/users/";
+            url += std::to_string(ids[static_cast<std::size_t>(i)]);
+            if (i % 5 == 0) {
+                url += "/profile";
+            }
+            res.push_back(std::move(url));
+        }
+        res.push_back("");
+        res.push_back("https://downloads.example.com/");
+        test_helpers::shuffle(res);
+        return res;
+    }
+}
+
+TEST_CASE( "string sorts" ) {
+    for (int size : { 0, 10, 254, 255, 256, 1000, 5000 }) {
+        auto const vec = make_urls(size);
+        auto expected = vec;
+        std::ranges::sort(expected);
+
+        auto copy = vec;
+        gfx::timsort(copy);
+        CHECK(copy == expected);
+
+        // Partially ordered
+        copy = vec;
+        std::ranges::sort(copy.begin(), copy.begin() + copy.size() / 2);
+        std::ranges::sort(copy.begin() + copy.size() / 2, copy.end(), std::greater<>{});
+        gfx::timsort(copy.begin(), copy.end(), std::less<>{});
+        CHECK(copy == expected);
+
+        std::vector<std::string_view> views(vec.begin(), vec.end());
+        gfx::timsort(views);
+        CHECK(std::ranges::equal(views, expected));
+
+        std::deque<std::string> deq(vec.begin(), vec.end());
+        gfx::timsort(deq, std::less<std::string>{});
+        CHECK(std::ranges::equal(deq, expected));
+
+        // Other comparisons aren't specialized
+        copy = vec;
+        gfx::timsort(copy, std::greater<>{});
+        CHECK(std::ranges::equal(copy, expected | std::views::reverse));
+    }
+
+    SECTION( "fixed-size ranges" ) {
+        auto urls = make_urls(298);
+        std::array<std::string, 300> arr;
+        std::ranges::move(urls, arr.begin());
+        gfx::timsort(arr);
+        CHECK(std::ranges::is_sorted(arr));
+    }
+}
+
+TEST_CASE( "string sorts are stable" ) {
+    // Few distinct keys, most of them with a common prefix
+    std::vector<std::pair<std::string, int>> vec;
+    for (int i = 0; i < 3000; ++i) {
+        vec.emplace_back(std::string(i % 4 == 0 ? 0 : 40, 'a') + std::to_string(i % 37), i);
+    }
+    test_helpers::shuffle(vec);
+    auto expected = vec;
+    std::ranges::stable_sort(expected, {}, &std::pair<std::string, int>::first);
+
+    gfx::timsort(vec, {}, &std::pair<std::string, int>::first);
+    CHECK(vec == expected);
+
+    // Projections returning views
+    auto as_view = [](std::pair<std::string, int> const& pair) {
+        return std::string_view(pair.first);
+    };
+    std::ranges::reverse(vec);
+    auto reversed = vec;
+    std::ranges::stable_sort(reversed, {}, as_view);
+    gfx::timsort(vec, {}, as_view);
+    CHECK(vec == reversed);
+}
+
+TEST_CASE( "string sorts skip common prefixes" ) {
+    std::vector<counted_string> vec;
+    for (const auto& url : make_urls(2000)) {
+        vec.emplace_back(url.begin(), url.end());
+    }
+    auto copy = vec;
+
+    compared_chars = 0;
+    gfx::timsort(vec);
+    auto const lcp_chars = compared_chars;
+    CHECK(std::ranges::is_sorted(vec));
+
+    // A comparator other than the default one disables the common prefix cache
+    compared_chars = 0;
+    gfx::timsort(copy, [](auto const& lhs, auto const& rhs) { return lhs < rhs; });
+    auto const plain_chars = compared_chars;
+    CHECK(copy == vec);
+
+    CHECK(lcp_chars * 2 < plain_chars);
+}
@@ -9,9 +9,18 @@
 #define GFX_TIMSORT_TEST_HELPERS_HPP
 
 #include <algorithm>
+#include <cstddef>
 #include <iterator>
 #include <random>
 #include <utility>
+#include <vector>
+
+// Whether the algorithms audit their preconditions and postconditions, which calls the
+// comparison functions outside of the algorithms themselves. gfx/timsort.hpp undefines its
+// configuration macros, so the files relying on this one include this header first
+#if defined(GFX_TIMSORT_ENABLE_AUDIT) && !defined(NDEBUG)
+#   define AUDITED_SORTS
+#endif
 
 namespace Catch
 {
@@ -50,6 +59,23 @@ namespace test_helpers {
         return x.first < y.first;
     }
 
+    // Values tagged with their index in the input: all the elements
+    // are distinct, so any reordering of equal values is noticed
+
+    typedef std::pair<int, int> indexed_t;
+
+    inline bool indexed_less(indexed_t x, indexed_t y) {
+        return x.first < y.first;
+    }
+
+    // Expected result of stably sorting a range
+    template <typename Range, typename Compare>
+    Range stable_sorted(Range range, Compare comp)
+    {
+        std::stable_sort(range.begin(), range.end(), comp);
+        return range;
+    }
+
     ////////////////////////////////////////////////////////////
     // Timsort should work with iterators that don't have a
     // post-increment or post-decrement operation
@@ -194,6 +220,55 @@ namespace test_helpers {
     {
         test_helpers::shuffle(std::begin(range), std::end(range));
     }
+
+    ////////////////////////////////////////////////////////////
+    // Input generators
+
+    // Shuffled values in [0, distinct), all of them about as
+    // frequent as each other
+    inline std::vector<int> duplicated_values(int size, int distinct)
+    {
+        std::vector<int> res;
+        res.reserve(static_cast<std::size_t>(size));
+        for (int i = 0; i < size; ++i) {
+            res.push_back((i * 7919) % distinct);
+        }
+        test_helpers::shuffle(res);
+        return res;
+    }
+
+    // Values tagged with their index
+    inline std::vector<indexed_t> indexed(std::vector<int> const& values)
+    {
+        std::vector<indexed_t> res;
+        res.reserve(values.size());
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            res.push_back(indexed_t(values[i], static_cast<int>(i)));
+        }
+        return res;
+    }
+
+    // The same values tagged to check the stability of the sort
+    inline std::vector<indexed_t> duplicated_pairs(int size, int distinct)
+    {
+        return indexed(duplicated_values(size, distinct));
+    }
+
+    // Shuffled permutation of [0, size) where the first run_length
+    // values of every stride values are sorted
+    inline std::vector<int> shuffled_runs(int size, int stride, int run_length)
+    {
+        std::vector<int> res;
+        res.reserve(static_cast<std::size_t>(size));
+        for (int i = 0; i < size; ++i) {
+            res.push_back(i);
+        }
+        test_helpers::shuffle(res);
+        for (int i = 0; i < size; i += stride) {
+            std::sort(res.begin() + i, res.begin() + (std::min)(i + run_length, size));
+        }
+        return res;
+    }
 }
 
 #endif // GFX_TIMSORT_TEST_HELPERS_HPP